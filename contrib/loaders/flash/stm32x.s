@@ -20,37 +20,58 @@
 
 	.text
 	.syntax unified
+	.cpu cortex-m3
 	.thumb
 	.thumb_func
 	.global write
 
 /*
-	r0 - source address
-	r1 - target address
-	r2 - count (halfword-16bit)
-	r3 - result
-	r4 - temp
+	r0 - flash base (in), status (out)
+	r1 - count (halfword-16bit)
+	r2 - fifo start
+	r3 - fifo end
+	r4 - target address
+	r5 - rp
+	r6 - temp
+	r7 - temp
+
+	The fifo is laid out as [wp][rp][data...], see target_run_fifo_algorithm().
+	The host aborts by writing zero to wp; we report an error by writing zero
+	to rp.
 */
 
 #define STM32_FLASH_CR_OFFSET	0x10			/* offset of CR register in FLASH struct */
-#define STM32_FLASH_SR_OFFSET	0x0c			/* offset of CR register in FLASH struct */
+#define STM32_FLASH_SR_OFFSET	0x0c			/* offset of SR register in FLASH struct */
 
 write:
-	ldr		r4, STM32_FLASH_BASE
-write_half_word:
-	movs	r3, #0x01
-	str		r3, [r4, #STM32_FLASH_CR_OFFSET]	/* PG (bit0) == 1 => flash programming enabled */
-	ldrh 	r3, [r0], #0x02						/* read one half-word from src, increment ptr */
-	strh 	r3, [r1], #0x02						/* write one half-word from src, increment ptr */
+	movs	r7, #0x01
+	str		r7, [r0, #STM32_FLASH_CR_OFFSET]	/* PG (bit0) == 1 => flash programming enabled */
+wait_fifo:
+	ldr		r6, [r2, #0]						/* read wp */
+	cmp		r6, #0								/* abort if wp == 0 */
+	beq		exit
+	ldr		r5, [r2, #4]						/* read rp */
+	cmp		r5, r6								/* wait until rp != wp */
+	beq		wait_fifo
+	ldrh	r6, [r5], #0x02						/* read one half-word from fifo, increment ptr */
+	strh	r6, [r4], #0x02						/* write one half-word to flash, increment ptr */
 busy:
-	ldr 	r3, [r4, #STM32_FLASH_SR_OFFSET]
-	tst 	r3, #0x01							/* BSY (bit0) == 1 => operation in progress */
-	beq 	busy								/* wait more... */
-	tst		r3, #0x14							/* PGERR (bit2) == 1 or WRPRTERR (bit4) == 1 => error */
-	bne		exit								/* fail... */
-	subs	r2, r2, #0x01						/* decrement counter */
-	bne		write_half_word						/* write next half-word if anything left */
+	ldr		r6, [r0, #STM32_FLASH_SR_OFFSET]
+	tst		r6, #0x01							/* BSY (bit0) == 1 => operation in progress */
+	bne		busy								/* wait more... */
+	tst		r6, #0x14							/* PGERR (bit2) == 1 or WRPRTERR (bit4) == 1 => error */
+	bne		error								/* fail... */
+	cmp		r5, r3								/* wrap rp at end of buffer */
+	bcc		no_wrap
+	adds	r5, r2, #8
+no_wrap:
+	str		r5, [r2, #4]						/* store rp */
+	subs	r1, r1, #0x01						/* decrement counter */
+	bne		wait_fifo							/* write next half-word if anything left */
+	b		exit
+error:
+	movs	r5, #0
+	str		r5, [r2, #4]						/* set rp = 0 on error */
 exit:
+	mov		r0, r6								/* return status in r0 */
 	bkpt	#0x00
-
-STM32_FLASH_BASE: .word 0x40022000				/* base address of FLASH struct */
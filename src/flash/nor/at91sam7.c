@@ -925,6 +925,7 @@ static int at91sam7_erase(struct flash_bank *bank, int first, int last)
 	uint32_t nbytes, pos;
 	uint8_t *buffer;
 	uint8_t erase_all;
+	int retval = ERROR_OK;
 
 	if (at91sam7_info->cidr == 0)
 	{
@@ -950,13 +951,16 @@ static int at91sam7_erase(struct flash_bank *bank, int first, int last)
 
 	/* Configure the flash controller timing */
 	at91sam7_read_clock_info(bank);
+
+	/* queue the mode and command writes; the status poll sends them */
+	target_begin_write_combining(bank->target);
 	at91sam7_set_flash_mode(bank, FMR_TIMING_FLASH);
 
 	if (erase_all)
 	{
 		if (at91sam7_flash_command(bank, EA, 0) != ERROR_OK)
 		{
-			return ERROR_FLASH_OPERATION_FAILED;
+			retval = ERROR_FLASH_OPERATION_FAILED;
 		}
 	}
 	else
@@ -971,12 +975,17 @@ static int at91sam7_erase(struct flash_bank *bank, int first, int last)
 
 		if (at91sam7_write(bank, buffer, bank->sectors[first].offset, nbytes) != ERROR_OK)
 		{
-			return ERROR_FLASH_OPERATION_FAILED;
+			retval = ERROR_FLASH_OPERATION_FAILED;
 		}
 
 		free(buffer);
 	}
 
+	if (target_end_write_combining(bank->target) != ERROR_OK)
+		retval = ERROR_FLASH_OPERATION_FAILED;
+	if (retval != ERROR_OK)
+		return retval;
+
 	/* mark erased sectors */
 	for (sec = first; sec <= last; sec++)
 	{
@@ -991,6 +1000,7 @@ static int at91sam7_protect(struct flash_bank *bank, int set, int first, int las
 	uint32_t cmd;
 	int sector;
 	uint32_t pagen;
+	int retval = ERROR_OK;
 
 	struct at91sam7_flash_bank *at91sam7_info = bank->driver_priv;
 
@@ -1012,6 +1022,9 @@ static int at91sam7_protect(struct flash_bank *bank, int set, int first, int las
 
 	/* Configure the flash controller timing */
 	at91sam7_read_clock_info(bank);
+
+	/* queue the mode and command writes; the status polls send them */
+	target_begin_write_combining(bank->target);
 	at91sam7_set_flash_mode(bank, FMR_TIMING_NVBITS);
 
 	for (sector = first; sector <= last; sector++)
@@ -1027,10 +1040,16 @@ static int at91sam7_protect(struct flash_bank *bank, int set, int first, int las
 
 		if (at91sam7_flash_command(bank, cmd, pagen) != ERROR_OK)
 		{
-			return ERROR_FLASH_OPERATION_FAILED;
+			retval = ERROR_FLASH_OPERATION_FAILED;
+			break;
 		}
 	}
 
+	if (target_end_write_combining(bank->target) != ERROR_OK)
+		retval = ERROR_FLASH_OPERATION_FAILED;
+	if (retval != ERROR_OK)
+		return retval;
+
 	at91sam7_protect_check(bank);
 
 	return ERROR_OK;
@@ -28,6 +28,7 @@
 #include <flash/nor/core.h>
 #include <flash/nor/imp.h>
 #include <target/image.h>
+#include <target/mem_cache.h>
 
 
 /**
@@ -44,6 +45,8 @@ int flash_driver_erase(struct flash_bank *bank, int first, int last)
 	int retval;
 
 	retval = bank->driver->erase(bank, first, last);
+	/* the flash changed behind the memory cache's back */
+	target_mem_cache_invalidate(bank->target);
 	if (retval != ERROR_OK)
 	{
 		LOG_ERROR("failed erasing sectors %d to %d (%d)", first, last, retval);
@@ -78,6 +81,7 @@ int flash_driver_protect(struct flash_bank *bank, int set, int first, int last)
 	 * Drivers only receive valid sector range.
 	 */
 	retval = bank->driver->protect(bank, set, first, last);
+	target_mem_cache_invalidate(bank->target);
 	if (retval != ERROR_OK)
 	{
 		LOG_ERROR("failed setting protection for areas %d to %d (%d)", first, last, retval);
@@ -92,6 +96,7 @@ int flash_driver_write(struct flash_bank *bank,
 	int retval;
 
 	retval = bank->driver->write(bank, buffer, offset, count);
+	target_mem_cache_invalidate(bank->target);
 	if (retval != ERROR_OK)
 	{
 		LOG_ERROR("error writing to flash at address 0x%08" PRIx32 " at offset 0x%8.8" PRIx32 " (%d)",
@@ -576,8 +581,127 @@ static int compare_section (const void * a, const void * b)
 }
 
 
+/* unlock, erase and program one run of a bank */
+static int flash_write_run(struct target *target, struct flash_bank *c,
+		uint8_t *buffer, uint32_t run_address, uint32_t run_size,
+		int erase, bool unlock)
+{
+	int retval = ERROR_OK;
+
+	if (unlock)
+	{
+		retval = flash_unlock_address_range(target, run_address, run_size);
+	}
+	if (retval == ERROR_OK)
+	{
+		if (erase)
+		{
+			/* calculate and erase sectors */
+			retval = flash_erase_address_range(target,
+					true, run_address, run_size);
+		}
+	}
+
+	if (retval == ERROR_OK)
+	{
+		/* write flash sectors */
+		retval = flash_driver_write(c, buffer, run_address - c->base, run_size);
+	}
+
+	return retval;
+}
+
+/* Compare each sector of a run with what the target already holds, using
+ * the (on-chip, where available) CRC, and only erase and program the
+ * ranges of sectors which differ.  *written gets the bytes programmed.
+ */
+static int flash_write_changed_sectors(struct target *target,
+		struct flash_bank *c, uint8_t *buffer,
+		uint32_t run_address, uint32_t run_size,
+		bool unlock, uint32_t *written)
+{
+	uint32_t offset_start = run_address - c->base;
+	uint32_t offset_end = offset_start + run_size;
+	uint32_t dirty_start = 0, dirty_end = 0;
+	uint32_t host_crc, target_crc;
+	int skipped = 0;
+	int retval;
+	int i;
+
+	*written = 0;
+
+	/* the whole run is often unchanged; one checksum tells */
+	image_calculate_checksum(buffer, run_size, &host_crc);
+	retval = target_checksum_memory(target, run_address, run_size, &target_crc);
+	if (retval == ERROR_OK && host_crc == target_crc)
+	{
+		LOG_INFO("flash at 0x%8.8" PRIx32 " (%" PRIu32 " bytes) is unchanged",
+				run_address, run_size);
+		return ERROR_OK;
+	}
+
+	for (i = 0; i < c->num_sectors; i++)
+	{
+		/* the part of this sector which the run covers */
+		uint32_t start = c->sectors[i].offset;
+		uint32_t end = start + c->sectors[i].size;
+
+		if (end <= offset_start)
+			continue;
+		if (start >= offset_end)
+			break;
+		if (start < offset_start)
+			start = offset_start;
+		if (end > offset_end)
+			end = offset_end;
+
+		image_calculate_checksum(buffer + start - offset_start,
+				end - start, &host_crc);
+		retval = target_checksum_memory(target, c->base + start,
+				end - start, &target_crc);
+		if (retval != ERROR_OK || host_crc != target_crc)
+		{
+			/* grow the pending range of changed sectors */
+			if (dirty_start == dirty_end)
+				dirty_start = start;
+			dirty_end = end;
+			continue;
+		}
+		skipped++;
+
+		if (dirty_start == dirty_end)
+			continue;
+
+		retval = flash_write_run(target, c,
+				buffer + dirty_start - offset_start,
+				c->base + dirty_start, dirty_end - dirty_start,
+				1, unlock);
+		if (retval != ERROR_OK)
+			return retval;
+		*written += dirty_end - dirty_start;
+		dirty_start = dirty_end = 0;
+	}
+
+	if (dirty_start != dirty_end)
+	{
+		retval = flash_write_run(target, c,
+				buffer + dirty_start - offset_start,
+				c->base + dirty_start, dirty_end - dirty_start,
+				1, unlock);
+		if (retval != ERROR_OK)
+			return retval;
+		*written += dirty_end - dirty_start;
+	}
+
+	if (skipped)
+		LOG_INFO("skipped %d unchanged sector(s) in flash bank %d",
+				skipped, c->bank_number);
+
+	return ERROR_OK;
+}
+
 int flash_write_unlock(struct target *target, struct image *image,
-		uint32_t *written, int erase, bool unlock)
+		uint32_t *written, int erase, bool unlock, bool incremental)
 {
 	int retval = ERROR_OK;
 
@@ -592,6 +716,10 @@ int flash_write_unlock(struct target *target, struct image *image,
 	if (written)
 		*written = 0;
 
+	/* only changed sectors get erased, but they do get erased */
+	if (incremental)
+		erase = 1;
+
 	if (erase)
 	{
 		/* assume all sectors need erasing - stops any problems
@@ -620,9 +748,10 @@ int flash_write_unlock(struct target *target, struct image *image,
 	while (section < image->num_sections)
 	{
 		uint32_t buffer_size;
-		uint8_t *buffer;
+		uint8_t *data, *buffer;
 		int section_first;
 		int section_last;
+		uint32_t run_written;
 		uint32_t run_address = sections[section]->base_address + section_offset;
 		uint32_t run_size = sections[section]->size - section_offset;
 		int pad_bytes = 0;
@@ -721,77 +850,89 @@ int flash_write_unlock(struct target *target, struct image *image,
 			run_size += delta;
 		}
 
-		/* allocate buffer */
-		buffer = malloc(run_size);
-		if (buffer == NULL)
-		{
-			LOG_ERROR("Out of memory for flash bank buffer");
-			retval = ERROR_FAIL;
-			goto done;
-		}
-		buffer_size = 0;
-
-		/* read sections to the buffer */
-		while (buffer_size < run_size)
+		/* a run of a single section without padding can be written
+		 * straight from the image, without copying it */
+		if ((section_last == section) && (padding[section] == 0)
+				&& (run_size <= sections[section]->size - section_offset))
 		{
 			size_t size_read;
-
-			size_read = run_size - buffer_size;
-			if (size_read > sections[section]->size - section_offset)
-			    size_read = sections[section]->size - section_offset;
-
-			/* KLUDGE!
-			 *
-			 * #¤%#"%¤% we have to figure out the section # from the sorted
-			 * list of pointers to sections to invoke image_read_section()...
-			 */
 			intptr_t diff = (intptr_t)sections[section] - (intptr_t)image->sections;
 			int t_section_num = diff / sizeof(struct imagesection);
 
-			LOG_DEBUG("image_read_section: section = %d, t_section_num = %d, section_offset = %d, buffer_size = %d, size_read = %d",
-				 (int)section,
-(int)t_section_num, (int)section_offset, (int)buffer_size, (int)size_read);
-			if ((retval = image_read_section(image, t_section_num, section_offset,
-					size_read, buffer + buffer_size, &size_read)) != ERROR_OK || size_read == 0)
-			{
-				free(buffer);
+			if ((retval = image_get_section(image, t_section_num, section_offset,
+					run_size, &data, &buffer, &size_read)) != ERROR_OK)
 				goto done;
-			}
-
-			/* see if we need to pad the section */
-			while (padding[section]--)
-				 (buffer + buffer_size)[size_read++] = 0xff;
-
-			buffer_size += size_read;
-			section_offset += size_read;
 
+			section_offset += run_size;
 			if (section_offset >= sections[section]->size)
 			{
 				section++;
 				section_offset = 0;
 			}
 		}
-
-		retval = ERROR_OK;
-
-		if (unlock)
-		{
-			retval = flash_unlock_address_range(target, run_address, run_size);
-		}
-		if (retval == ERROR_OK)
+		else
 		{
-			if (erase)
+			/* allocate buffer */
+			buffer = malloc(run_size);
+			if (buffer == NULL)
+			{
+				LOG_ERROR("Out of memory for flash bank buffer");
+				retval = ERROR_FAIL;
+				goto done;
+			}
+			buffer_size = 0;
+
+			/* read sections to the buffer */
+			while (buffer_size < run_size)
 			{
-				/* calculate and erase sectors */
-				retval = flash_erase_address_range(target,
-						true, run_address, run_size);
+				size_t size_read;
+
+				size_read = run_size - buffer_size;
+				if (size_read > sections[section]->size - section_offset)
+				    size_read = sections[section]->size - section_offset;
+
+				/* KLUDGE!
+				 *
+				 * #¤%#"%¤% we have to figure out the section # from the sorted
+				 * list of pointers to sections to invoke image_read_section()...
+				 */
+				intptr_t diff = (intptr_t)sections[section] - (intptr_t)image->sections;
+				int t_section_num = diff / sizeof(struct imagesection);
+
+				LOG_DEBUG("image_read_section: section = %d, t_section_num = %d, section_offset = %d, buffer_size = %d, size_read = %d",
+					 (int)section,
+					 (int)t_section_num, (int)section_offset, (int)buffer_size, (int)size_read);
+				if ((retval = image_read_section(image, t_section_num, section_offset,
+						size_read, buffer + buffer_size, &size_read)) != ERROR_OK || size_read == 0)
+				{
+					free(buffer);
+					goto done;
+				}
+
+				/* see if we need to pad the section */
+				while (padding[section]--)
+					 (buffer + buffer_size)[size_read++] = 0xff;
+
+				buffer_size += size_read;
+				section_offset += size_read;
+
+				if (section_offset >= sections[section]->size)
+				{
+					section++;
+					section_offset = 0;
+				}
 			}
+			data = buffer;
 		}
 
-		if (retval == ERROR_OK)
+		if (incremental)
+			retval = flash_write_changed_sectors(target, c, data,
+					run_address, run_size, unlock, &run_written);
+		else
 		{
-			/* write flash sectors */
-			retval = flash_driver_write(c, buffer, run_address - c->base, run_size);
+			retval = flash_write_run(target, c, data,
+					run_address, run_size, erase, unlock);
+			run_written = run_size;
 		}
 
 		free(buffer);
@@ -803,7 +944,7 @@ int flash_write_unlock(struct target *target, struct image *image,
 		}
 
 		if (written != NULL)
-			*written += run_size; /* add run size to total written counter */
+			*written += run_written; /* add run size to total written counter */
 	}
 
 
@@ -817,5 +958,249 @@ done:
 int flash_write(struct target *target, struct image *image,
 		uint32_t *written, int erase)
 {
-	return flash_write_unlock(target, image, written, erase, false);
+	return flash_write_unlock(target, image, written, erase, false, false);
+}
+
+/* one sector's worth of data waiting to be programmed */
+struct flash_stream_chunk {
+	struct flash_stream_chunk *next;
+	struct flash_bank *bank;
+	uint32_t offset;	/* of the sector, in the bank */
+	uint32_t size;		/* of the sector */
+	uint32_t start, end;	/* part received so far, gaps are 0xff */
+	uint8_t *data;
+};
+
+struct flash_stream {
+	struct target *target;
+	/* partly received sectors, in address order */
+	struct flash_stream_chunk *chunks;
+	uint32_t written;
+	/* the first error seen, later data is dropped */
+	int retval;
+};
+
+struct flash_stream *flash_stream_open(struct target *target)
+{
+	struct flash_stream *stream = calloc(1, sizeof(*stream));
+
+	if (stream)
+	{
+		stream->target = target;
+		stream->retval = ERROR_OK;
+	}
+	return stream;
+}
+
+/* find, or start, the chunk for the sector holding @a addr; *result is
+ * NULL if there's no flash there */
+static int flash_stream_chunk(struct flash_stream *stream, uint32_t addr,
+		struct flash_stream_chunk **result)
+{
+	struct flash_stream_chunk **prev, *chunk;
+	struct flash_bank *c;
+	uint32_t offset;
+	int retval;
+	int i;
+
+	for (prev = &stream->chunks; (chunk = *prev) != NULL; prev = &chunk->next)
+	{
+		uint32_t address = chunk->bank->base + chunk->offset;
+
+		if (addr < address)
+			break;
+		if (addr - address < chunk->size)
+		{
+			*result = chunk;
+			return ERROR_OK;
+		}
+	}
+
+	*result = NULL;
+	retval = get_flash_bank_by_addr(stream->target, addr, false, &c);
+	if (retval != ERROR_OK || c == NULL)
+		return retval;
+
+	chunk = malloc(sizeof(*chunk));
+	if (chunk == NULL)
+		return ERROR_FAIL;
+	chunk->bank = c;
+
+	/* without a sector list, the whole bank is one chunk */
+	offset = addr - c->base;
+	chunk->offset = 0;
+	chunk->size = c->size;
+	for (i = 0; i < c->num_sectors; i++)
+	{
+		if (offset - c->sectors[i].offset < c->sectors[i].size)
+		{
+			chunk->offset = c->sectors[i].offset;
+			chunk->size = c->sectors[i].size;
+			break;
+		}
+	}
+	chunk->start = chunk->end = 0;
+
+	chunk->data = malloc(chunk->size);
+	if (chunk->data == NULL)
+	{
+		LOG_ERROR("Out of memory for flash sector buffer");
+		free(chunk);
+		return ERROR_FAIL;
+	}
+	memset(chunk->data, 0xff, chunk->size);
+
+	chunk->next = *prev;
+	*prev = chunk;
+	*result = chunk;
+
+	return ERROR_OK;
+}
+
+int flash_stream_add(struct flash_stream *stream, uint32_t addr,
+		const uint8_t *data, uint32_t size)
+{
+	while (size > 0)
+	{
+		struct flash_stream_chunk *chunk;
+		uint32_t offset, count;
+		int retval;
+
+		retval = flash_stream_chunk(stream, addr, &chunk);
+		if (retval != ERROR_OK)
+		{
+			if (stream->retval == ERROR_OK)
+				stream->retval = retval;
+			return retval;
+		}
+
+		/* not flash; flash_write() skips such data too */
+		if (chunk == NULL)
+			return ERROR_OK;
+
+		offset = addr - chunk->bank->base - chunk->offset;
+		count = chunk->size - offset;
+		if (count > size)
+			count = size;
+
+		memcpy(chunk->data + offset, data, count);
+		if (chunk->start == chunk->end)
+		{
+			chunk->start = offset;
+			chunk->end = offset + count;
+		}
+		else
+		{
+			if (offset < chunk->start)
+				chunk->start = offset;
+			if (offset + count > chunk->end)
+				chunk->end = offset + count;
+		}
+
+		addr += count;
+		data += count;
+		size -= count;
+	}
+
+	return ERROR_OK;
+}
+
+/* does @a next carry on where @a chunk ends, so both can be programmed
+ * with one write? */
+static bool flash_stream_chunks_adjacent(struct flash_stream_chunk *chunk,
+		struct flash_stream_chunk *next)
+{
+	return next->bank == chunk->bank
+			&& chunk->end == chunk->size
+			&& next->offset == chunk->offset + chunk->size
+			&& next->start == 0;
+}
+
+int flash_stream_program(struct flash_stream *stream, bool partial)
+{
+	struct flash_stream_chunk **prev = &stream->chunks, *chunk;
+
+	while ((chunk = *prev) != NULL)
+	{
+		struct flash_stream_chunk *last, *next;
+		uint32_t size;
+
+		/* wait for the rest of the sector */
+		if (!partial && chunk->end != chunk->size)
+		{
+			prev = &chunk->next;
+			continue;
+		}
+
+		/* program a run of consecutive sectors in one go */
+		last = chunk;
+		size = chunk->end - chunk->start;
+		while ((next = last->next) != NULL
+				&& flash_stream_chunks_adjacent(last, next)
+				&& (partial || next->end == next->size))
+		{
+			size += next->end;
+			last = next;
+		}
+
+		if (stream->retval == ERROR_OK)
+		{
+			uint8_t *buffer = chunk->data + chunk->start;
+
+			if (last != chunk)
+			{
+				uint32_t copied = 0;
+
+				buffer = malloc(size);
+				if (buffer == NULL)
+				{
+					LOG_ERROR("Out of memory for flash write buffer");
+					stream->retval = ERROR_FAIL;
+				}
+				for (next = chunk; buffer && copied < size; next = next->next)
+				{
+					memcpy(buffer + copied, next->data + next->start,
+							next->end - next->start);
+					copied += next->end - next->start;
+				}
+			}
+
+			if (buffer)
+				stream->retval = flash_driver_write(chunk->bank, buffer,
+						chunk->offset + chunk->start, size);
+			if (stream->retval == ERROR_OK)
+				stream->written += size;
+
+			if (last != chunk)
+				free(buffer);
+		}
+
+		*prev = last->next;
+		last->next = NULL;
+		while (chunk != NULL)
+		{
+			next = chunk->next;
+			free(chunk->data);
+			free(chunk);
+			chunk = next;
+		}
+	}
+
+	return stream->retval;
+}
+
+void flash_stream_close(struct flash_stream *stream, uint32_t *written)
+{
+	struct flash_stream_chunk *chunk;
+
+	while ((chunk = stream->chunks) != NULL)
+	{
+		stream->chunks = chunk->next;
+		free(chunk->data);
+		free(chunk);
+	}
+
+	if (written)
+		*written = stream->written;
+	free(stream);
 }
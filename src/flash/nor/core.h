@@ -129,6 +129,42 @@ int flash_unlock_address_range(struct target *target, uint32_t addr,
 int flash_write(struct target *target,
 		struct image *image, uint32_t *written, int erase);
 
+/**
+ * A flash stream programs data as it arrives, a sector at a time, so
+ * programming can overlap with receiving the rest (e.g. from GDB's
+ * vFlashWrite packets).  Data is buffered per sector; each sector is
+ * written once all of it has been received.  Like flash_write() with
+ * no @a erase, nothing is erased, and data outside flash is ignored.
+ */
+struct flash_stream;
+
+/// @returns A new flash stream for @a target, or NULL if out of memory.
+struct flash_stream *flash_stream_open(struct target *target);
+
+/**
+ * Buffers @a size bytes of @a data for flash at @a addr; nothing is
+ * programmed.  Data is kept in address order; writes may come in any
+ * order, but a sector already programmed would be programmed again.
+ * @returns ERROR_OK if successful; otherwise, an error code.
+ */
+int flash_stream_add(struct flash_stream *stream, uint32_t addr,
+		const uint8_t *data, uint32_t size);
+
+/**
+ * Programs the sectors which have been received in full, or with
+ * @a partial, all buffered data.  Runs of consecutive sectors are
+ * programmed with one write.  Once an error has happened, data is
+ * dropped rather than programmed.
+ * @returns ERROR_OK, or the first error seen by this stream.
+ */
+int flash_stream_program(struct flash_stream *stream, bool partial);
+
+/**
+ * Frees @a stream, dropping data which wasn't programmed.
+ * @param written On return, contains the number of bytes programmed.
+ */
+void flash_stream_close(struct flash_stream *stream, uint32_t *written);
+
 /**
  * Forces targets to re-examine their erase/protection state.
  * This routine must be called when the system may modify the status.
@@ -43,8 +43,9 @@ int flash_driver_write(struct flash_bank *bank,
 int flash_driver_read(struct flash_bank *bank,
 		uint8_t *buffer, uint32_t offset, uint32_t count);
 
-/* write (optional verify) an image to flash memory of the given target */
+/* write (optional verify) an image to flash memory of the given target;
+ * when incremental, only sectors whose CRC differs are erased and written */
 int flash_write_unlock(struct target *target, struct image *image,
-		uint32_t *written, int erase, bool unlock);
+		uint32_t *written, int erase, bool unlock, bool incremental);
 
 #endif // FLASH_NOR_IMP_H
@@ -955,7 +955,10 @@ static int stellaris_write_block(struct flash_bank *bank,
 	init_reg_param(&reg_params[1], "r1", 32, PARAM_OUT);
 	init_reg_param(&reg_params[2], "r2", 32, PARAM_OUT);
 
-	while (wcount > 0)
+	/* save the core state once, not around every buffer */
+	retval = target_begin_algorithm_session(target, &armv7m_info);
+
+	while ((retval == ERROR_OK) && (wcount > 0))
 	{
 		uint32_t thisrun_count = (wcount > (buffer_size / 4)) ? (buffer_size / 4) : wcount;
 
@@ -986,6 +989,8 @@ static int stellaris_write_block(struct flash_bank *bank,
 		wcount -= thisrun_count;
 	}
 
+	target_end_algorithm_session(target, &armv7m_info);
+
 	/* REVISIT we could speed up writing multi-section images by
 	 * not freeing the initialized write_algorithm this way.
 	 */
@@ -32,6 +32,7 @@
 
 /* stm32x register locations */
 
+#define STM32_FLASH_BASE	0x40022000
 #define STM32_FLASH_ACR		0x40022000
 #define STM32_FLASH_KEYR	0x40022004
 #define STM32_FLASH_OPTKEYR	0x40022008
@@ -215,135 +216,145 @@ static int stm32x_erase_options(struct flash_bank *bank)
 {
 	struct stm32x_flash_bank *stm32x_info = NULL;
 	struct target *target = bank->target;
+	int retval, retval2;
 
 	stm32x_info = bank->driver_priv;
 
 	/* read current options */
 	stm32x_read_options(bank);
 
+	/* queue the register writes; the status polls send them */
+	target_begin_write_combining(target);
+
 	/* unlock flash registers */
-	int retval = target_write_u32(target, STM32_FLASH_KEYR, KEY1);
+	retval = target_write_u32(target, STM32_FLASH_KEYR, KEY1);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 
 	retval = target_write_u32(target, STM32_FLASH_KEYR, KEY2);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 
 	/* unlock option flash registers */
 	retval = target_write_u32(target, STM32_FLASH_OPTKEYR, KEY1);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 	retval = target_write_u32(target, STM32_FLASH_OPTKEYR, KEY2);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 
 	/* erase option bytes */
 	retval = target_write_u32(target, STM32_FLASH_CR, FLASH_OPTER | FLASH_OPTWRE);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 	retval = target_write_u32(target, STM32_FLASH_CR, FLASH_OPTER | FLASH_STRT | FLASH_OPTWRE);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 
 	retval = stm32x_wait_status_busy(bank, 10);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 
 	/* clear readout protection and complementary option bytes
 	 * this will also force a device unlock if set */
 	stm32x_info->option_bytes.RDP = 0x5AA5;
 
-	return ERROR_OK;
+done:
+	retval2 = target_end_write_combining(target);
+	return (retval != ERROR_OK) ? retval : retval2;
 }
 
 static int stm32x_write_options(struct flash_bank *bank)
 {
 	struct stm32x_flash_bank *stm32x_info = NULL;
 	struct target *target = bank->target;
+	int retval, retval2;
 
 	stm32x_info = bank->driver_priv;
 
+	/* queue the register writes; the status polls send them */
+	target_begin_write_combining(target);
+
 	/* unlock flash registers */
-	int retval = target_write_u32(target, STM32_FLASH_KEYR, KEY1);
+	retval = target_write_u32(target, STM32_FLASH_KEYR, KEY1);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 	retval = target_write_u32(target, STM32_FLASH_KEYR, KEY2);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 
 	/* unlock option flash registers */
 	retval = target_write_u32(target, STM32_FLASH_OPTKEYR, KEY1);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 	retval = target_write_u32(target, STM32_FLASH_OPTKEYR, KEY2);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 
 	/* program option bytes */
 	retval = target_write_u32(target, STM32_FLASH_CR, FLASH_OPTPG | FLASH_OPTWRE);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 
 	/* write user option byte */
 	retval = target_write_u16(target, STM32_OB_USER, stm32x_info->option_bytes.user_options);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 
 	retval = stm32x_wait_status_busy(bank, 10);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 
 	/* write protection byte 1 */
 	retval = target_write_u16(target, STM32_OB_WRP0, stm32x_info->option_bytes.protection[0]);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 
 	retval = stm32x_wait_status_busy(bank, 10);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 
 	/* write protection byte 2 */
 	retval = target_write_u16(target, STM32_OB_WRP1, stm32x_info->option_bytes.protection[1]);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 
 	retval = stm32x_wait_status_busy(bank, 10);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 
 	/* write protection byte 3 */
 	retval = target_write_u16(target, STM32_OB_WRP2, stm32x_info->option_bytes.protection[2]);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 
 	retval = stm32x_wait_status_busy(bank, 10);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 
 	/* write protection byte 4 */
 	retval = target_write_u16(target, STM32_OB_WRP3, stm32x_info->option_bytes.protection[3]);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 
 	retval = stm32x_wait_status_busy(bank, 10);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 
 	/* write readout protection bit */
 	retval = target_write_u16(target, STM32_OB_RDP, stm32x_info->option_bytes.RDP);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 
 	retval = stm32x_wait_status_busy(bank, 10);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 
 	retval = target_write_u32(target, STM32_FLASH_CR, FLASH_LOCK);
-	if (retval != ERROR_OK)
-		return retval;
 
-	return ERROR_OK;
+done:
+	retval2 = target_end_write_combining(target);
+	return (retval != ERROR_OK) ? retval : retval2;
 }
 
 static int stm32x_protect_check(struct flash_bank *bank)
@@ -423,6 +434,7 @@ static int stm32x_protect_check(struct flash_bank *bank)
 static int stm32x_erase(struct flash_bank *bank, int first, int last)
 {
 	struct target *target = bank->target;
+	int retval, retval2;
 	int i;
 
 	if (bank->target->state != TARGET_HALTED)
@@ -436,38 +448,41 @@ static int stm32x_erase(struct flash_bank *bank, int first, int last)
 		return stm32x_mass_erase(bank);
 	}
 
+	/* queue the register writes; the status polls send them */
+	target_begin_write_combining(target);
+
 	/* unlock flash registers */
-	int retval = target_write_u32(target, STM32_FLASH_KEYR, KEY1);
+	retval = target_write_u32(target, STM32_FLASH_KEYR, KEY1);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 	retval = target_write_u32(target, STM32_FLASH_KEYR, KEY2);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 
 	for (i = first; i <= last; i++)
 	{
 		retval = target_write_u32(target, STM32_FLASH_CR, FLASH_PER);
 		if (retval != ERROR_OK)
-			return retval;
+			goto done;
 		retval = target_write_u32(target, STM32_FLASH_AR, bank->base + bank->sectors[i].offset);
 		if (retval != ERROR_OK)
-			return retval;
+			goto done;
 		retval = target_write_u32(target, STM32_FLASH_CR, FLASH_PER | FLASH_STRT);
 		if (retval != ERROR_OK)
-			return retval;
+			goto done;
 
 		retval = stm32x_wait_status_busy(bank, 100);
 		if (retval != ERROR_OK)
-			return retval;
+			goto done;
 
 		bank->sectors[i].is_erased = 1;
 	}
 
 	retval = target_write_u32(target, STM32_FLASH_CR, FLASH_LOCK);
-	if (retval != ERROR_OK)
-		return retval;
 
-	return ERROR_OK;
+done:
+	retval2 = target_end_write_combining(target);
+	return (retval != ERROR_OK) ? retval : retval2;
 }
 
 static int stm32x_protect(struct flash_bank *bank, int set, int first, int last)
@@ -569,8 +584,9 @@ static int stm32x_write_block(struct flash_bank *bank, uint8_t *buffer,
 	uint32_t buffer_size = 16384;
 	struct working_area *source;
 	uint32_t address = bank->base + offset;
-	struct reg_param reg_params[4];
+	struct reg_param reg_params[5];
 	struct armv7m_algorithm armv7m_info;
+	uint32_t status;
 	int retval = ERROR_OK;
 
 	/* see contib/loaders/flash/stm32x.s for src */
@@ -579,23 +595,37 @@ static int stm32x_write_block(struct flash_bank *bank, uint8_t *buffer,
 									/* #define STM32_FLASH_CR_OFFSET	0x10 */
 									/* #define STM32_FLASH_SR_OFFSET	0x0C */
 									/* write: */
-		0xdf, 0xf8, 0x20, 0x40,		/* ldr	r4, STM32_FLASH_BASE */
-									/* write_half_word: */
-		0x01, 0x23,					/* movs	r3, #0x01 */
-		0x23, 0x61,					/* str	r3, [r4, #STM32_FLASH_CR_OFFSET] */
-		0x30, 0xf8, 0x02, 0x3b,		/* ldrh	r3, [r0], #0x02 */
-		0x21, 0xf8, 0x02, 0x3b,		/* strh	r3, [r1], #0x02 */
+		0x01, 0x27,					/* movs	r7, #0x01 */
+		0x07, 0x61,					/* str	r7, [r0, #STM32_FLASH_CR_OFFSET] */
+									/* wait_fifo: */
+		0x16, 0x68,					/* ldr	r6, [r2, #0] */
+		0x00, 0x2e,					/* cmp	r6, #0 */
+		0x17, 0xd0,					/* beq	exit */
+		0x55, 0x68,					/* ldr	r5, [r2, #4] */
+		0xb5, 0x42,					/* cmp	r5, r6 */
+		0xf9, 0xd0,					/* beq	wait_fifo */
+		0x35, 0xf8, 0x02, 0x6b,		/* ldrh	r6, [r5], #0x02 */
+		0x24, 0xf8, 0x02, 0x6b,		/* strh	r6, [r4], #0x02 */
 									/* busy: */
-		0xe3, 0x68,					/* ldr	r3, [r4, #STM32_FLASH_SR_OFFSET] */
-		0x13, 0xf0, 0x01, 0x0f,		/* tst	r3, #0x01 */
-		0xfb, 0xd0,					/* beq	busy */
-		0x13, 0xf0, 0x14, 0x0f,		/* tst	r3, #0x14 */
-		0x01, 0xd1,					/* bne	exit */
-		0x01, 0x3a,					/* subs	r2, r2, #0x01 */
-		0xf0, 0xd1,					/* bne	write_half_word */
+		0xc6, 0x68,					/* ldr	r6, [r0, #STM32_FLASH_SR_OFFSET] */
+		0x16, 0xf0, 0x01, 0x0f,		/* tst	r6, #0x01 */
+		0xfb, 0xd1,					/* bne	busy */
+		0x16, 0xf0, 0x14, 0x0f,		/* tst	r6, #0x14 */
+		0x07, 0xd1,					/* bne	error */
+		0x9d, 0x42,					/* cmp	r5, r3 */
+		0x01, 0xd3,					/* bcc	no_wrap */
+		0x12, 0xf1, 0x08, 0x05,		/* adds	r5, r2, #8 */
+									/* no_wrap: */
+		0x55, 0x60,					/* str	r5, [r2, #4] */
+		0x49, 0x1e,					/* subs	r1, r1, #0x01 */
+		0xe7, 0xd1,					/* bne	wait_fifo */
+		0x01, 0xe0,					/* b	exit */
+									/* error: */
+		0x00, 0x25,					/* movs	r5, #0 */
+		0x55, 0x60,					/* str	r5, [r2, #4] */
 									/* exit: */
+		0x30, 0x46,					/* mov	r0, r6 */
 		0x00, 0xbe,					/* bkpt	#0x00 */
-		0x00, 0x20, 0x02, 0x40,		/* STM32_FLASH_BASE: .word 0x40022000 */
 	};
 
 	/* flash write code */
@@ -611,8 +641,8 @@ static int stm32x_write_block(struct flash_bank *bank, uint8_t *buffer,
 			(uint8_t*)stm32x_flash_write_code)) != ERROR_OK)
 		return retval;
 
-	/* memory buffer */
-	while (target_alloc_working_area_try(target, buffer_size, &source) != ERROR_OK)
+	/* fifo: wp and rp words, then the data */
+	while (target_alloc_working_area_try(target, buffer_size + 8, &source) != ERROR_OK)
 	{
 		buffer_size /= 2;
 		if (buffer_size <= 256)
@@ -630,55 +660,44 @@ static int stm32x_write_block(struct flash_bank *bank, uint8_t *buffer,
 	armv7m_info.common_magic = ARMV7M_COMMON_MAGIC;
 	armv7m_info.core_mode = ARMV7M_MODE_ANY;
 
-	init_reg_param(&reg_params[0], "r0", 32, PARAM_OUT);
-	init_reg_param(&reg_params[1], "r1", 32, PARAM_OUT);
-	init_reg_param(&reg_params[2], "r2", 32, PARAM_OUT);
-	init_reg_param(&reg_params[3], "r3", 32, PARAM_IN);
-
-	while (count > 0)
-	{
-		uint32_t thisrun_count = (count > (buffer_size / 2)) ?
-				(buffer_size / 2) : count;
-
-		if ((retval = target_write_buffer(target, source->address,
-				thisrun_count * 2, buffer)) != ERROR_OK)
-			break;
+	init_reg_param(&reg_params[0], "r0", 32, PARAM_IN_OUT);	/* flash base (in), status (out) */
+	init_reg_param(&reg_params[1], "r1", 32, PARAM_OUT);	/* count (halfword-16bit) */
+	init_reg_param(&reg_params[2], "r2", 32, PARAM_OUT);	/* fifo start */
+	init_reg_param(&reg_params[3], "r3", 32, PARAM_OUT);	/* fifo end */
+	init_reg_param(&reg_params[4], "r4", 32, PARAM_OUT);	/* target address */
 
-		buf_set_u32(reg_params[0].value, 0, 32, source->address);
-		buf_set_u32(reg_params[1].value, 0, 32, address);
-		buf_set_u32(reg_params[2].value, 0, 32, thisrun_count);
+	buf_set_u32(reg_params[0].value, 0, 32, STM32_FLASH_BASE);
+	buf_set_u32(reg_params[1].value, 0, 32, count);
+	buf_set_u32(reg_params[2].value, 0, 32, source->address);
+	buf_set_u32(reg_params[3].value, 0, 32, source->address + source->size);
+	buf_set_u32(reg_params[4].value, 0, 32, address);
 
-		if ((retval = target_run_algorithm(target, 0, NULL, 4, reg_params,
-				stm32x_info->write_algorithm->address,
-				0,
-				10000, &armv7m_info)) != ERROR_OK)
-		{
-			LOG_ERROR("error executing stm32x flash write algorithm");
-			break;
-		}
-
-		if (buf_get_u32(reg_params[3].value, 0, 32) & FLASH_PGERR)
-		{
-			LOG_ERROR("flash memory not erased before writing");
-			/* Clear but report errors */
-			target_write_u32(target, STM32_FLASH_SR, FLASH_PGERR);
-			retval = ERROR_FAIL;
-			break;
-		}
+	/* the loader programs while we keep its fifo topped up */
+	retval = target_run_fifo_algorithm(target, buffer, count, 2,
+			0, NULL,
+			5, reg_params,
+			source->address, source->size,
+			stm32x_info->write_algorithm->address, 0,
+			10000, &armv7m_info);
 
-		if (buf_get_u32(reg_params[3].value, 0, 32) & FLASH_WRPRTERR)
-		{
-			LOG_ERROR("flash memory write protected");
-			/* Clear but report errors */
-			target_write_u32(target, STM32_FLASH_SR, FLASH_WRPRTERR);
-			retval = ERROR_FAIL;
-			break;
-		}
+	status = buf_get_u32(reg_params[0].value, 0, 32);
 
-		buffer += thisrun_count * 2;
-		address += thisrun_count * 2;
-		count -= thisrun_count;
+	if (status & FLASH_PGERR)
+	{
+		LOG_ERROR("flash memory not erased before writing");
+		/* Clear but report errors */
+		target_write_u32(target, STM32_FLASH_SR, FLASH_PGERR);
+		retval = ERROR_FAIL;
 	}
+	else if (status & FLASH_WRPRTERR)
+	{
+		LOG_ERROR("flash memory write protected");
+		/* Clear but report errors */
+		target_write_u32(target, STM32_FLASH_SR, FLASH_WRPRTERR);
+		retval = ERROR_FAIL;
+	}
+	else if (retval != ERROR_OK)
+		LOG_ERROR("error executing stm32x flash write algorithm");
 
 	target_free_working_area(target, source);
 	target_free_working_area(target, stm32x_info->write_algorithm);
@@ -687,6 +706,7 @@ static int stm32x_write_block(struct flash_bank *bank, uint8_t *buffer,
 	destroy_reg_param(&reg_params[1]);
 	destroy_reg_param(&reg_params[2]);
 	destroy_reg_param(&reg_params[3]);
+	destroy_reg_param(&reg_params[4]);
 
 	return retval;
 }
@@ -699,7 +719,7 @@ static int stm32x_write(struct flash_bank *bank, uint8_t *buffer,
 	uint32_t bytes_remaining = (count & 0x00000001);
 	uint32_t address = bank->base + offset;
 	uint32_t bytes_written = 0;
-	int retval;
+	int retval, retval2;
 
 	if (bank->target->state != TARGET_HALTED)
 	{
@@ -747,19 +767,44 @@ static int stm32x_write(struct flash_bank *bank, uint8_t *buffer,
 
 	while (words_remaining > 0)
 	{
+		struct target_async_read status;
 		uint16_t value;
 		memcpy(&value, buffer + bytes_written, sizeof(uint16_t));
 
+		/* program the half word and read the status in one flush;
+		 * the flash must not be busy before the next one, so poll
+		 * BSY if it hasn't cleared yet */
+		target_begin_write_combining(target);
 		retval = target_write_u32(target, STM32_FLASH_CR, FLASH_PG);
-		if (retval != ERROR_OK)
-			return retval;
-		retval = target_write_u16(target, address, value);
+		if (retval == ERROR_OK)
+			retval = target_write_u16(target, address, value);
+		if (retval == ERROR_OK)
+			retval = target_read_u32_async(target, STM32_FLASH_SR, &status);
+		retval2 = target_end_write_combining(target);
+		if (retval == ERROR_OK)
+			retval = retval2;
+		/* a caller may be write combining too */
+		retval2 = target_flush(target);
+		if (retval == ERROR_OK)
+			retval = retval2;
 		if (retval != ERROR_OK)
 			return retval;
 
-		retval = stm32x_wait_status_busy(bank, 5);
-		if (retval != ERROR_OK)
-			return retval;
+		if (!status.done)
+		{
+			LOG_ERROR("BUG: flash status read wasn't flushed");
+			return ERROR_FAIL;
+		}
+		if (status.retval != ERROR_OK)
+			return status.retval;
+
+		/* errors are sticky, so this reports and clears them too */
+		if (status.value & (FLASH_BSY | FLASH_WRPRTERR | FLASH_PGERR))
+		{
+			retval = stm32x_wait_status_busy(bank, 5);
+			if (retval != ERROR_OK)
+				return retval;
+		}
 
 		bytes_written += 2;
 		words_remaining--;
@@ -1300,6 +1345,7 @@ COMMAND_HANDLER(stm32x_handle_options_write_command)
 static int stm32x_mass_erase(struct flash_bank *bank)
 {
 	struct target *target = bank->target;
+	int retval, retval2;
 
 	if (target->state != TARGET_HALTED)
 	{
@@ -1307,31 +1353,34 @@ static int stm32x_mass_erase(struct flash_bank *bank)
 		return ERROR_TARGET_NOT_HALTED;
 	}
 
+	/* queue the register writes; the status polls send them */
+	target_begin_write_combining(target);
+
 	/* unlock option flash registers */
-	int retval = target_write_u32(target, STM32_FLASH_KEYR, KEY1);
+	retval = target_write_u32(target, STM32_FLASH_KEYR, KEY1);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 	retval = target_write_u32(target, STM32_FLASH_KEYR, KEY2);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 
 	/* mass erase flash memory */
 	retval = target_write_u32(target, STM32_FLASH_CR, FLASH_MER);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 	retval = target_write_u32(target, STM32_FLASH_CR, FLASH_MER | FLASH_STRT);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 
 	retval = stm32x_wait_status_busy(bank, 100);
 	if (retval != ERROR_OK)
-		return retval;
+		goto done;
 
 	retval = target_write_u32(target, STM32_FLASH_CR, FLASH_LOCK);
-	if (retval != ERROR_OK)
-		return retval;
 
-	return ERROR_OK;
+done:
+	retval2 = target_end_write_combining(target);
+	return (retval != ERROR_OK) ? retval : retval2;
 }
 
 COMMAND_HANDLER(stm32x_handle_mass_erase_command)
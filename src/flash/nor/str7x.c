@@ -554,7 +554,10 @@ static int str7x_write_block(struct flash_bank *bank, uint8_t *buffer,
 	init_reg_param(&reg_params[4], "r4", 32, PARAM_IN);
 	init_reg_param(&reg_params[5], "r5", 32, PARAM_OUT);
 
-	while (count > 0)
+	/* save the core state once, not around every buffer */
+	retval = target_begin_algorithm_session(target, &armv4_5_info);
+
+	while ((retval == ERROR_OK) && (count > 0))
 	{
 		uint32_t thisrun_count = (count > (buffer_size / 8)) ? (buffer_size / 8) : count;
 
@@ -585,6 +588,8 @@ static int str7x_write_block(struct flash_bank *bank, uint8_t *buffer,
 		count -= thisrun_count;
 	}
 
+	target_end_algorithm_session(target, &armv4_5_info);
+
 	target_free_working_area(target, source);
 	target_free_working_area(target, str7x_info->write_algorithm);
 
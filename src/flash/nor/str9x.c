@@ -462,7 +462,10 @@ static int str9x_write_block(struct flash_bank *bank,
 	init_reg_param(&reg_params[2], "r2", 32, PARAM_OUT);
 	init_reg_param(&reg_params[3], "r3", 32, PARAM_IN);
 
-	while (count > 0)
+	/* save the core state once, not around every buffer */
+	retval = target_begin_algorithm_session(target, &armv4_5_info);
+
+	while ((retval == ERROR_OK) && (count > 0))
 	{
 		uint32_t thisrun_count = (count > (buffer_size / 2)) ? (buffer_size / 2) : count;
 
@@ -492,6 +495,8 @@ static int str9x_write_block(struct flash_bank *bank,
 		count -= thisrun_count;
 	}
 
+	target_end_algorithm_session(target, &armv4_5_info);
+
 	target_free_working_area(target, source);
 	target_free_working_area(target, str9x_info->write_algorithm);
 
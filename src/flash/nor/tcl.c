@@ -375,6 +375,7 @@ COMMAND_HANDLER(handle_flash_write_image_command)
 	/* flash auto-erase is disabled by default*/
 	int auto_erase = 0;
 	bool auto_unlock = false;
+	bool incremental = false;
 
 	for (;;)
 	{
@@ -390,6 +391,12 @@ COMMAND_HANDLER(handle_flash_write_image_command)
 			CMD_ARGV++;
 			CMD_ARGC--;
 			command_print(CMD_CTX, "auto unlock enabled");
+		} else if (strcmp(CMD_ARGV[0], "incremental") == 0)
+		{
+			incremental = true;
+			CMD_ARGV++;
+			CMD_ARGC--;
+			command_print(CMD_CTX, "incremental write enabled");
 		} else
 		{
 			break;
@@ -429,7 +436,8 @@ COMMAND_HANDLER(handle_flash_write_image_command)
 		return retval;
 	}
 
-	retval = flash_write_unlock(target, &image, &written, auto_erase, auto_unlock);
+	retval = flash_write_unlock(target, &image, &written,
+			auto_erase, auto_unlock, incremental);
 	if (retval != ERROR_OK)
 	{
 		image_close(&image);
@@ -741,9 +749,11 @@ static const struct command_registration flash_exec_command_handlers[] = {
 		.name = "write_image",
 		.handler = handle_flash_write_image_command,
 		.mode = COMMAND_EXEC,
-		.usage = "[erase] [unlock] filename [offset [file_type]]",
+		.usage = "[erase] [unlock] [incremental] "
+			"filename [offset [file_type]]",
 		.help = "Write an image to flash.  Optionally first unprotect "
-			"and/or erase the region to be used.  Allow optional "
+			"and/or erase the region to be used, or only erase and "
+			"write sectors whose contents changed.  Allow optional "
 			"offset from beginning of bank (defaults to zero)",
 	},
 	{
@@ -83,7 +83,7 @@ bool buf_cmp(const void *_buf1, const void *_buf2, unsigned size)
 
 	unsigned last = size / 8;
 	if (memcmp(_buf1, _buf2, last) != 0)
-		return false;
+		return true;
 
 	unsigned trailing = size % 8;
 	if (!trailing)
@@ -101,7 +101,19 @@ bool buf_cmp_mask(const void *_buf1, const void *_buf2,
 
 	const uint8_t *buf1 = _buf1, *buf2 = _buf2, *mask = _mask;
 	unsigned last = size / 8;
-	for (unsigned i = 0; i < last; i++)
+	unsigned i = 0;
+
+	/* a word at a time; byte order doesn't matter for this */
+	for (; i + 8 <= last; i += 8)
+	{
+		uint64_t a, b, m;
+		memcpy(&a, buf1 + i, 8);
+		memcpy(&b, buf2 + i, 8);
+		memcpy(&m, mask + i, 8);
+		if ((a ^ b) & m)
+			return true;
+	}
+	for (; i < last; i++)
 	{
 		if (buf_cmp_masked(buf1[i], buf2[i], mask[i]))
 			return true;
@@ -128,13 +140,9 @@ void* buf_set_ones(void *_buf, unsigned size)
 	return buf;
 }
 
-void* buf_set_buf(const void *_src, unsigned src_start,
-		void *_dst, unsigned dst_start, unsigned len)
+static void buf_copy_bits(const uint8_t *src, unsigned src_idx,
+		uint8_t *dst, unsigned dst_idx, unsigned len)
 {
-	const uint8_t *src = _src;
-	uint8_t *dst = _dst;
-
-	unsigned src_idx = src_start, dst_idx = dst_start;
 	for (unsigned i = 0; i < len; i++)
 	{
 		if (((src[src_idx / 8] >> (src_idx % 8)) & 1) == 1)
@@ -144,6 +152,67 @@ void* buf_set_buf(const void *_src, unsigned src_start,
 		dst_idx++;
 		src_idx++;
 	}
+}
+
+static inline uint64_t buf_get_le_u64(const uint8_t *buf)
+{
+	return (uint64_t)le_to_h_u32(buf) | (uint64_t)le_to_h_u32(buf + 4) << 32;
+}
+
+static inline void buf_set_le_u64(uint8_t *buf, uint64_t value)
+{
+	h_u32_to_le(buf, value);
+	h_u32_to_le(buf + 4, value >> 32);
+}
+
+void* buf_set_buf(const void *_src, unsigned src_start,
+		void *_dst, unsigned dst_start, unsigned len)
+{
+	const uint8_t *src = _src;
+	uint8_t *dst = _dst;
+
+	/* both byte aligned, as with most scan fields: just copy bytes */
+	if (src_start % 8 == 0 && dst_start % 8 == 0)
+	{
+		memcpy(dst + dst_start / 8, src + src_start / 8, len / 8);
+		buf_copy_bits(src, src_start + len - len % 8,
+				dst, dst_start + len - len % 8, len % 8);
+		return dst;
+	}
+
+	/* copy bit by bit until the destination is byte aligned ... */
+	unsigned head = (8 - dst_start % 8) % 8;
+	if (head > len)
+		head = len;
+	buf_copy_bits(src, src_start, dst, dst_start, head);
+	src_start += head;
+	dst_start += head;
+	len -= head;
+
+	/* ... then shift whole words, and bytes, out of the source.  Every
+	 * source byte touched holds at least one of the bits being copied.
+	 */
+	const uint8_t *s = src + src_start / 8;
+	uint8_t *d = dst + dst_start / 8;
+	unsigned shift = src_start % 8;
+
+	if (shift == 0)
+	{
+		memcpy(d, s, len / 8);
+		s += len / 8;
+		d += len / 8;
+	}
+	else
+	{
+		for (; len >= 64; len -= 64, s += 8, d += 8)
+			buf_set_le_u64(d, buf_get_le_u64(s) >> shift
+					| (uint64_t)s[8] << (64 - shift));
+		for (; len >= 8; len -= 8, s++, d++)
+			*d = (s[0] >> shift) | (s[1] << (8 - shift));
+	}
+
+	/* and whatever is left, bit by bit */
+	buf_copy_bits(s, shift, d, 0, len % 8);
 
 	return dst;
 }
@@ -64,6 +64,15 @@ int fileio_read(struct fileio *fileio,
 int fileio_write(struct fileio *fileio,
 		size_t size, const void *buffer, size_t *size_written);
 
+/**
+ * Map a file opened for reading into memory, so its contents can be
+ * used in place rather than copied out with fileio_read().  The mapping
+ * is private: writes to it don't reach the file, and it's released by
+ * fileio_close().  Returns ERROR_FILEIO_OPERATION_NOT_SUPPORTED where
+ * files can't be mapped; callers should then fall back to reading.
+ */
+int fileio_map(struct fileio *fileio, uint8_t **data);
+
 int fileio_read_u32(struct fileio *fileio, uint32_t *data);
 int fileio_write_u32(struct fileio *fileio, uint32_t data);
 int fileio_size(struct fileio *fileio, int *size);
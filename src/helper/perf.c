@@ -0,0 +1,213 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "log.h"
+#include "command.h"
+#include "time_support.h"
+#include "perf.h"
+
+uint64_t perf_counters[PERF_NUM_COUNTERS];
+
+static const char *perf_counter_names[PERF_NUM_COUNTERS] = {
+	[PERF_JTAG_FLUSHES] = "jtag_flushes",
+	[PERF_JTAG_CMD_SCAN] = "jtag_cmd_scan",
+	[PERF_JTAG_CMD_TLR_RESET] = "jtag_cmd_tlr_reset",
+	[PERF_JTAG_CMD_RUNTEST] = "jtag_cmd_runtest",
+	[PERF_JTAG_CMD_RESET] = "jtag_cmd_reset",
+	[PERF_JTAG_CMD_PATHMOVE] = "jtag_cmd_pathmove",
+	[PERF_JTAG_CMD_SLEEP] = "jtag_cmd_sleep",
+	[PERF_JTAG_CMD_STABLECLOCKS] = "jtag_cmd_stableclocks",
+	[PERF_JTAG_CMD_TMS] = "jtag_cmd_tms",
+	[PERF_JTAG_BITS_OUT] = "jtag_bits_out",
+	[PERF_JTAG_BITS_IN] = "jtag_bits_in",
+	[PERF_JTAG_EXECUTE_US] = "jtag_execute_us",
+	[PERF_ADAPTER_WRITES] = "adapter_writes",
+	[PERF_ADAPTER_READS] = "adapter_reads",
+	[PERF_ADAPTER_BYTES_OUT] = "adapter_bytes_out",
+	[PERF_ADAPTER_BYTES_IN] = "adapter_bytes_in",
+	[PERF_TARGET_READ_U8] = "target_read_u8",
+	[PERF_TARGET_READ_U16] = "target_read_u16",
+	[PERF_TARGET_READ_U32] = "target_read_u32",
+	[PERF_TARGET_READ_BYTES] = "target_read_bytes",
+	[PERF_TARGET_WRITE_U8] = "target_write_u8",
+	[PERF_TARGET_WRITE_U16] = "target_write_u16",
+	[PERF_TARGET_WRITE_U32] = "target_write_u32",
+	[PERF_TARGET_WRITE_BYTES] = "target_write_bytes",
+	[PERF_WORKING_AREA_ALLOCS] = "working_area_allocs",
+	[PERF_WORKING_AREA_FAILS] = "working_area_fails",
+	[PERF_WORKING_AREA_BYTES] = "working_area_bytes",
+	[PERF_TARGET_CACHE_HITS] = "mem_cache_hits",
+	[PERF_TARGET_CACHE_MISSES] = "mem_cache_misses",
+	[PERF_GDB_PACKETS_REGS] = "gdb_packets_regs",
+	[PERF_GDB_PACKETS_MEM_READ] = "gdb_packets_mem_read",
+	[PERF_GDB_PACKETS_MEM_WRITE] = "gdb_packets_mem_write",
+	[PERF_GDB_PACKETS_RUN] = "gdb_packets_run",
+	[PERF_GDB_PACKETS_BREAK] = "gdb_packets_break",
+	[PERF_GDB_PACKETS_QUERY] = "gdb_packets_query",
+	[PERF_GDB_PACKETS_FLASH] = "gdb_packets_flash",
+	[PERF_GDB_PACKETS_OTHER] = "gdb_packets_other",
+};
+
+/* periodic dump to the log; zero means off */
+static int perf_log_interval;
+static long long perf_log_next;
+/* the counters as of the last dump, so it shows what changed */
+static uint64_t perf_logged[PERF_NUM_COUNTERS];
+
+void perf_reset(void)
+{
+	memset(perf_counters, 0, sizeof(perf_counters));
+	memset(perf_logged, 0, sizeof(perf_logged));
+}
+
+static void perf_log(void)
+{
+	char line[256];
+	int len = 0;
+	unsigned i;
+
+	/* only the counters that moved since the last dump, by how
+	 * much, a few per line */
+	for (i = 0; i < PERF_NUM_COUNTERS; i++)
+	{
+		uint64_t delta = perf_counters[i] - perf_logged[i];
+
+		if (!delta)
+			continue;
+		perf_logged[i] = perf_counters[i];
+
+		len += snprintf(line + len, sizeof(line) - len, " %s=+%" PRIu64,
+				perf_counter_names[i], delta);
+		if (len > 160)
+		{
+			LOG_INFO("perf:%s", line);
+			len = 0;
+		}
+	}
+	if (len)
+		LOG_INFO("perf:%s", line);
+}
+
+void perf_poll(void)
+{
+	long long now;
+
+	if (!perf_log_interval)
+		return;
+
+	now = timeval_ms();
+	if (now < perf_log_next)
+		return;
+
+	perf_log_next = now + perf_log_interval;
+	perf_log();
+}
+
+static int jim_perf_stats(Jim_Interp *interp, int argc, Jim_Obj *const *argv)
+{
+	Jim_Obj *dict;
+	unsigned i;
+
+	if (argc != 1)
+	{
+		Jim_WrongNumArgs(interp, 1, argv, "(no params)");
+		return JIM_ERR;
+	}
+
+	dict = Jim_NewListObj(interp, NULL, 0);
+	for (i = 0; i < PERF_NUM_COUNTERS; i++)
+	{
+		Jim_ListAppendElement(interp, dict,
+				Jim_NewStringObj(interp, perf_counter_names[i], -1));
+		Jim_ListAppendElement(interp, dict,
+				Jim_NewIntObj(interp, perf_counters[i]));
+	}
+	Jim_SetResult(interp, dict);
+
+	return JIM_OK;
+}
+
+COMMAND_HANDLER(handle_perf_reset_command)
+{
+	if (CMD_ARGC != 0)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	perf_reset();
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_perf_log_interval_command)
+{
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (CMD_ARGC == 1)
+	{
+		unsigned interval;
+		COMMAND_PARSE_NUMBER(uint, CMD_ARGV[0], interval);
+		perf_log_interval = interval;
+		perf_log_next = timeval_ms() + interval;
+	}
+
+	command_print(CMD_CTX, "perf log interval: %d ms", perf_log_interval);
+
+	return ERROR_OK;
+}
+
+static const struct command_registration perf_subcommand_handlers[] = {
+	{
+		.name = "stats",
+		.mode = COMMAND_ANY,
+		.jim_handler = jim_perf_stats,
+		.help = "Returns the performance counters, as a list of "
+			"name value pairs for use with 'dict'.",
+	},
+	{
+		.name = "reset",
+		.mode = COMMAND_ANY,
+		.handler = handle_perf_reset_command,
+		.help = "Zero all performance counters.",
+	},
+	{
+		.name = "log_interval",
+		.mode = COMMAND_ANY,
+		.handler = handle_perf_log_interval_command,
+		.help = "Display or set how often (in milliseconds) the "
+			"performance counters which moved are logged, with "
+			"the change since the last log; zero disables this.",
+		.usage = "[milliseconds]",
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+static const struct command_registration perf_command_handlers[] = {
+	{
+		.name = "perf",
+		.mode = COMMAND_ANY,
+		.help = "performance counter commands",
+		.chain = perf_subcommand_handlers,
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+int perf_register_commands(struct command_context *cmd_ctx)
+{
+	return register_commands(cmd_ctx, NULL, perf_command_handlers);
+}
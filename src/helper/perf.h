@@ -0,0 +1,96 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef HELPER_PERF_H
+#define HELPER_PERF_H
+
+#include <helper/types.h>
+
+/**
+ * Performance counters, kept by the JTAG, adapter, target and GDB
+ * layers and read back with the "perf stats" command.  Counting is
+ * a single add, so it's always on.
+ */
+enum perf_counter {
+	PERF_JTAG_FLUSHES,
+	/* commands handed to the driver, by type */
+	PERF_JTAG_CMD_SCAN,
+	PERF_JTAG_CMD_TLR_RESET,
+	PERF_JTAG_CMD_RUNTEST,
+	PERF_JTAG_CMD_RESET,
+	PERF_JTAG_CMD_PATHMOVE,
+	PERF_JTAG_CMD_SLEEP,
+	PERF_JTAG_CMD_STABLECLOCKS,
+	PERF_JTAG_CMD_TMS,
+	/* scan bits with data to send, and bits captured */
+	PERF_JTAG_BITS_OUT,
+	PERF_JTAG_BITS_IN,
+	/* time spent in the driver's execute_queue */
+	PERF_JTAG_EXECUTE_US,
+
+	/* USB (or other) transfers made by adapter drivers */
+	PERF_ADAPTER_WRITES,
+	PERF_ADAPTER_READS,
+	PERF_ADAPTER_BYTES_OUT,
+	PERF_ADAPTER_BYTES_IN,
+
+	/* target_read_memory() and target_write_memory(), by access size */
+	PERF_TARGET_READ_U8,
+	PERF_TARGET_READ_U16,
+	PERF_TARGET_READ_U32,
+	PERF_TARGET_READ_BYTES,
+	PERF_TARGET_WRITE_U8,
+	PERF_TARGET_WRITE_U16,
+	PERF_TARGET_WRITE_U32,
+	PERF_TARGET_WRITE_BYTES,
+
+	PERF_WORKING_AREA_ALLOCS,
+	PERF_WORKING_AREA_FAILS,
+	PERF_WORKING_AREA_BYTES,
+
+	/* lines served from, and fetched into, the target memory cache */
+	PERF_TARGET_CACHE_HITS,
+	PERF_TARGET_CACHE_MISSES,
+
+	/* GDB packets, by type */
+	PERF_GDB_PACKETS_REGS,		/* g G p P */
+	PERF_GDB_PACKETS_MEM_READ,	/* m */
+	PERF_GDB_PACKETS_MEM_WRITE,	/* M X */
+	PERF_GDB_PACKETS_RUN,		/* c s vCont */
+	PERF_GDB_PACKETS_BREAK,		/* z Z */
+	PERF_GDB_PACKETS_QUERY,		/* q Q */
+	PERF_GDB_PACKETS_FLASH,		/* vFlash* */
+	PERF_GDB_PACKETS_OTHER,
+
+	PERF_NUM_COUNTERS
+};
+
+extern uint64_t perf_counters[PERF_NUM_COUNTERS];
+
+static inline void perf_count(enum perf_counter counter, uint64_t n)
+{
+	perf_counters[counter] += n;
+}
+
+void perf_reset(void);
+
+/// Dump the counters to the log if the "perf log_interval" has passed.
+void perf_poll(void);
+
+struct command_context;
+int perf_register_commands(struct command_context *cmd_ctx);
+
+#endif // HELPER_PERF_H
@@ -36,12 +36,23 @@
 
 struct cmd_queue_page {
 	void *address;
+	size_t size;
 	size_t used;
 	struct cmd_queue_page *next;
 };
 
 #define CMD_QUEUE_PAGE_SIZE (1024 * 1024)
+
+/*
+ * The command queue is an arena: pages are allocated on demand and
+ * kept across jtag_command_queue_reset(), which only rewinds them.
+ * cmd_queue_cur_page is the page allocations are currently carved
+ * from; pages after it are free and get reused before new ones are
+ * allocated, so a steady-state session stops calling malloc() here.
+ */
 static struct cmd_queue_page *cmd_queue_pages = NULL;
+static struct cmd_queue_page *cmd_queue_cur_page = NULL;
+static struct cmd_queue_stats cmd_queue_stats;
 
 struct jtag_command *jtag_command_queue = NULL;
 static struct jtag_command **next_command_pointer = &jtag_command_queue;
@@ -60,10 +71,35 @@ void jtag_queue_command(struct jtag_command * cmd)
 	next_command_pointer = &cmd->next;
 }
 
+void jtag_queue_set_tail(struct jtag_command **link)
+{
+	assert(NULL == *link);
+	next_command_pointer = link;
+}
+
+static struct cmd_queue_page *cmd_queue_page_new(size_t size)
+{
+	struct cmd_queue_page *page;
+
+	if (size < CMD_QUEUE_PAGE_SIZE)
+		size = CMD_QUEUE_PAGE_SIZE;
+
+	page = malloc(sizeof(struct cmd_queue_page));
+	page->address = malloc(size);
+	page->size = size;
+	page->used = 0;
+	page->next = NULL;
+
+	cmd_queue_stats.pages++;
+	cmd_queue_stats.page_bytes += size;
+
+	return page;
+}
+
 void* cmd_queue_alloc(size_t size)
 {
-	struct cmd_queue_page **p_page = &cmd_queue_pages;
-	int offset;
+	struct cmd_queue_page *page = cmd_queue_cur_page;
+	size_t offset;
 	uint8_t *t;
 
 	/*
@@ -98,47 +134,72 @@ void* cmd_queue_alloc(size_t size)
 	size = (size + ALIGN_SIZE -1) & (~(ALIGN_SIZE-1));
 	/* Done... */
 
-	if (*p_page)
+	if (!page)
 	{
-		while ((*p_page)->next)
-			p_page = &((*p_page)->next);
-		if (CMD_QUEUE_PAGE_SIZE - (*p_page)->used < size)
-			p_page = &((*p_page)->next);
+		/* first allocation ever */
+		page = cmd_queue_page_new(size);
+		cmd_queue_pages = page;
 	}
-
-	if (!*p_page)
+	else if (page->size - page->used < size)
 	{
-		*p_page = malloc(sizeof(struct cmd_queue_page));
-		(*p_page)->used = 0;
-		(*p_page)->address = malloc(CMD_QUEUE_PAGE_SIZE);
-		(*p_page)->next = NULL;
+		/* move on to the next free page, if it is big enough;
+		 * else slip a fresh page in front of it
+		 */
+		struct cmd_queue_page *next = page->next;
+
+		if (!next || next->size < size)
+		{
+			struct cmd_queue_page *fresh = cmd_queue_page_new(size);
+			fresh->next = next;
+			page->next = fresh;
+			next = fresh;
+		}
+		page = next;
 	}
+	cmd_queue_cur_page = page;
+
+	offset = page->used;
+	page->used += size;
 
-	offset = (*p_page)->used;
-	(*p_page)->used += size;
+	cmd_queue_stats.used += size;
+	if (cmd_queue_stats.used > cmd_queue_stats.high_water)
+		cmd_queue_stats.high_water = cmd_queue_stats.used;
 
-	t = (uint8_t *)((*p_page)->address);
+	t = (uint8_t *)(page->address);
 	return t + offset;
 }
 
-static void cmd_queue_free(void)
+/* rewind the arena; all pages stay allocated for the next queue */
+static void cmd_queue_rewind(void)
 {
-	struct cmd_queue_page *page = cmd_queue_pages;
+	struct cmd_queue_page *page;
 
-	while (page)
+	for (page = cmd_queue_pages; page; page = page->next)
 	{
-		struct cmd_queue_page *last = page;
-		free(page->address);
-		page = page->next;
-		free(last);
+		page->used = 0;
+		if (page == cmd_queue_cur_page)
+			break;
 	}
 
-	cmd_queue_pages = NULL;
+	cmd_queue_cur_page = cmd_queue_pages;
+	cmd_queue_stats.used = 0;
+	cmd_queue_stats.resets++;
+}
+
+void cmd_queue_get_stats(struct cmd_queue_stats *stats)
+{
+	*stats = cmd_queue_stats;
+}
+
+void cmd_queue_reset_stats(void)
+{
+	cmd_queue_stats.high_water = cmd_queue_stats.used;
+	cmd_queue_stats.resets = 0;
 }
 
 void jtag_command_queue_reset(void)
 {
-	cmd_queue_free();
+	cmd_queue_rewind();
 
 	jtag_command_queue = NULL;
 	next_command_pointer = &jtag_command_queue;
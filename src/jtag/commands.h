@@ -166,8 +166,103 @@ extern struct jtag_command* jtag_command_queue;
 
 void* cmd_queue_alloc(size_t size);
 
+/**
+ * Usage figures for the arena backing cmd_queue_alloc().  Pages are
+ * recycled between queue flushes, so @c page_bytes only grows when a
+ * queue is bigger than any queue seen before.
+ */
+struct cmd_queue_stats {
+	/// number of pages owned by the arena
+	unsigned pages;
+	/// total bytes reserved by those pages
+	size_t page_bytes;
+	/// bytes handed out since the queue was last reset
+	size_t used;
+	/// largest value of @c used seen so far
+	size_t high_water;
+	/// number of queue resets (flushes) so far
+	unsigned resets;
+};
+
+void cmd_queue_get_stats(struct cmd_queue_stats *stats);
+void cmd_queue_reset_stats(void);
+
 void jtag_queue_command(struct jtag_command *cmd);
 void jtag_command_queue_reset(void);
+/**
+ * Tell the queue where the next command pointer lives, after commands
+ * were removed from its end.
+ * @param link Address of the last command's @c next field, or of
+ *	@c jtag_command_queue if the queue is now empty.
+ */
+void jtag_queue_set_tail(struct jtag_command **link);
+
+/**
+ * What jtag_optimize_queue() did since the stats were last reset.
+ * Cycle counts are estimates based on the TMS paths in use.
+ */
+struct jtag_optimize_stats {
+	/// queues passed through the optimizer
+	unsigned flushes;
+	/// commands seen, and commands left for the driver
+	unsigned long commands_in, commands_out;
+	/// IR scans dropped (or turned into a short pathmove)
+	unsigned long ir_scans_dropped;
+	/// runtest, pathmove and sleep commands folded into another
+	unsigned long runtests_merged, pathmoves_merged, sleeps_merged;
+	/// back-to-back TAP resets dropped
+	unsigned long resets_dropped;
+	/// TCK cycles no longer clocked
+	unsigned long long cycles_saved;
+};
+
+/**
+ * Optionally rewrite the pending command queue so it needs fewer TCK
+ * cycles and fewer commands, without changing what it does to the TAPs.
+ * Called just before the queue goes to the driver; does nothing unless
+ * enabled with jtag_optimize_enable().
+ */
+void jtag_optimize_queue(void);
+/// Forget the TAP state and IR contents, e.g. after a failed flush.
+void jtag_optimize_invalidate(void);
+void jtag_optimize_enable(bool enable);
+bool jtag_optimize_is_enabled(void);
+void jtag_optimize_get_stats(struct jtag_optimize_stats *stats);
+void jtag_optimize_reset_stats(void);
+
+/**
+ * Append the pending command queue to the trace being recorded, before
+ * it's optimized and handed to the driver.  Does nothing unless
+ * jtag_record_start() was called.
+ */
+void jtag_record_queue(void);
+/// Append the result and TDO data of the queue just executed.
+void jtag_record_results(int retval);
+int jtag_record_start(const char *filename);
+void jtag_record_stop(void);
+bool jtag_record_is_active(void);
+
+/**
+ * What jtag_replay() saw while playing back a trace.
+ */
+struct jtag_replay_stats {
+	/// commands queued, and queues flushed
+	unsigned long commands, flushes;
+	/// bits scanned, and TCK cycles spent outside of scans
+	unsigned long long bits, cycles;
+	/// flushes whose outcome differed from the recording
+	unsigned long result_mismatches;
+	/// fields which captured different TDO data
+	unsigned long tdo_mismatches;
+	/// time spent executing the queues
+	float seconds;
+};
+
+/**
+ * Play back a trace written by jtag_record_start() through the current
+ * driver, flushing the queue wherever the recording did.
+ */
+int jtag_replay(const char *filename, struct jtag_replay_stats *stats);
 
 enum scan_type jtag_scan_type(const struct scan_command* cmd);
 int jtag_scan_size(const struct scan_command* cmd);
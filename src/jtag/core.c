@@ -34,6 +34,8 @@
 #include "jtag.h"
 #include "interface.h"
 #include "transport.h"
+#include <helper/time_support.h>
+#include <helper/perf.h>
 
 #ifdef HAVE_STRINGS_H
 #include <strings.h>
@@ -827,12 +829,21 @@ int default_interface_jtag_execute_queue(void)
 		return ERROR_FAIL;
 	}
 
-	return jtag->execute_queue();
+	struct duration bench;
+	duration_start(&bench);
+
+	int retval = jtag->execute_queue();
+
+	duration_measure(&bench);
+	perf_count(PERF_JTAG_EXECUTE_US, duration_elapsed(&bench) * 1000000);
+
+	return retval;
 }
 
 void jtag_execute_queue_noclear(void)
 {
 	jtag_flush_queue_count++;
+	perf_count(PERF_JTAG_FLUSHES, 1);
 	jtag_set_error(interface_jtag_execute_queue());
 
 	if (jtag_flush_queue_sleep > 0)
@@ -36,6 +36,7 @@
 #include <jtag/commands.h>
 #include <jtag/minidriver.h>
 #include <helper/command.h>
+#include <helper/perf.h>
 
 struct jtag_callback_entry
 {
@@ -475,6 +476,40 @@ void interface_jtag_add_callback4(jtag_callback_t callback, jtag_callback_data_t
 	}
 }
 
+/* tally up what the driver is about to be asked to do */
+static void interface_jtag_count_queue(void)
+{
+	static const enum perf_counter counters[] = {
+		[JTAG_SCAN] = PERF_JTAG_CMD_SCAN,
+		[JTAG_TLR_RESET] = PERF_JTAG_CMD_TLR_RESET,
+		[JTAG_RUNTEST] = PERF_JTAG_CMD_RUNTEST,
+		[JTAG_RESET] = PERF_JTAG_CMD_RESET,
+		[JTAG_PATHMOVE] = PERF_JTAG_CMD_PATHMOVE,
+		[JTAG_SLEEP] = PERF_JTAG_CMD_SLEEP,
+		[JTAG_STABLECLOCKS] = PERF_JTAG_CMD_STABLECLOCKS,
+		[JTAG_TMS] = PERF_JTAG_CMD_TMS,
+	};
+	struct jtag_command *cmd;
+
+	for (cmd = jtag_command_queue; cmd; cmd = cmd->next)
+	{
+		/* gaps in the table are zero, i.e. PERF_JTAG_FLUSHES */
+		if ((unsigned)cmd->type < ARRAY_SIZE(counters) && counters[cmd->type])
+			perf_count(counters[cmd->type], 1);
+		if (cmd->type != JTAG_SCAN)
+			continue;
+
+		for (int i = 0; i < cmd->cmd.scan->num_fields; i++)
+		{
+			struct scan_field *field = cmd->cmd.scan->fields + i;
+			if (field->out_value)
+				perf_count(PERF_JTAG_BITS_OUT, field->num_bits);
+			if (field->in_value)
+				perf_count(PERF_JTAG_BITS_IN, field->num_bits);
+		}
+	}
+}
+
 int interface_jtag_execute_queue(void)
 {
 	static int reentry = 0;
@@ -482,7 +517,12 @@ int interface_jtag_execute_queue(void)
 	assert(reentry==0);
 	reentry++;
 
+	jtag_record_queue();
+	jtag_optimize_queue();
+	interface_jtag_count_queue();
+
 	int retval = default_interface_jtag_execute_queue();
+	jtag_record_results(retval);
 	if (retval == ERROR_OK)
 	{
 		struct jtag_callback_entry *entry;
@@ -492,6 +532,10 @@ int interface_jtag_execute_queue(void)
 			if (retval != ERROR_OK)
 				break;
 		}
+	} else
+	{
+		/* no telling how far the adapter got */
+		jtag_optimize_invalidate();
 	}
 
 	jtag_command_queue_reset();
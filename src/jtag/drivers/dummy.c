@@ -36,8 +36,689 @@ static int clock_count;         /* count clocks in any stable state, only stable
 static uint32_t dummy_data;
 
 
+/*
+ * Optional simulated scan chain.  Without any "dummy tap" commands
+ * the driver behaves as before, like an unresponsive target.  With
+ * them, every TCK edge is fed through a model of the listed TAPs,
+ * one of which may be an ADIv5 JTAG-DP with a MEM-AP in front of host
+ * memory and a Cortex-M style debug block.  That's enough for the
+ * target, flash and GDB layers to run against, without a probe, and
+ * to count exactly which JTAG traffic each operation costs.
+ *
+ * The core doesn't execute code.  When it's resumed it stops at the
+ * first BKPT instruction or enabled FPB comparator at or after the PC,
+ * as if it had run there; that's how algorithms hand back control.
+ */
+
+#define DUMMY_MAX_TAPS		8
+
+struct dummy_tap {
+	unsigned ir_len;
+	uint32_t idcode;
+	/// is this the JTAG-DP?
+	bool dap;
+
+	uint32_t ir;
+	uint64_t ir_shift;
+	uint64_t dr_shift;
+	unsigned dr_len;
+};
+
+/// TAPs in scan chain order; the first one is nearest TDO
+static struct dummy_tap dummy_taps[DUMMY_MAX_TAPS];
+static unsigned dummy_num_taps;
+
+/* JTAG-DP instructions and acknowledgements */
+#define DAP_IR_ABORT		0x8
+#define DAP_IR_DPACC		0xA
+#define DAP_IR_APACC		0xB
+#define DAP_IR_IDCODE		0xE
+#define DAP_ACK_OK_FAULT	0x2
+
+/* DP CTRL/STAT bits */
+#define DP_STICKYORUN		(1 << 1)
+#define DP_STICKYCMP		(1 << 4)
+#define DP_STICKYERR		(1 << 5)
+#define DP_CDBGPWRUPREQ		(1 << 28)
+#define DP_CSYSPWRUPREQ		(1 << 30)
+
+/* MEM-AP CSW bits */
+#define AP_CSW_SIZE_MASK	0x7
+#define AP_CSW_ADDRINC_MASK	(3 << 4)
+#define AP_CSW_ADDRINC_SINGLE	(1 << 4)
+#define AP_CSW_DEVICEEN		(1 << 6)
+
+/* the MEM-AP's identity: an AHB-AP whose ROM table is in the PPB */
+#define AP_IDR_VALUE		0x24770011
+#define AP_BASE_VALUE		0xE00FF003
+
+struct dummy_dap {
+	uint32_t ctrl_stat;
+	uint32_t select;
+	/// result of the last read, captured by the next DPACC/APACC scan
+	uint32_t read_result;
+	uint32_t csw;
+	uint32_t tar;
+};
+
+static struct dummy_dap dummy_dap;
+
+/* RAM regions behind the MEM-AP */
+struct dummy_memory {
+	uint32_t base;
+	uint32_t size;
+	uint8_t *data;
+	struct dummy_memory *next;
+};
+
+static struct dummy_memory *dummy_memories;
+
+/* The private peripheral bus holds the debug components */
+#define PPB_BASE		0xE0000000
+#define PPB_SIZE		0x00100000
+
+#define PPB_DWT_CTRL		0xE0001000
+#define PPB_DWT_PCSR		0xE000101C
+#define PPB_FP_CTRL		0xE0002000
+#define PPB_FP_COMP0		0xE0002008
+#define PPB_FP_NUM_CODE		6
+#define PPB_CPUID		0xE000ED00
+#define PPB_AIRCR		0xE000ED0C
+#define PPB_DFSR		0xE000ED30
+#define PPB_DHCSR		0xE000EDF0
+#define PPB_DCRSR		0xE000EDF4
+#define PPB_DCRDR		0xE000EDF8
+#define PPB_DEMCR		0xE000EDFC
+#define PPB_ROM_TABLE		0xE00FF000
+
+#define DHCSR_C_DEBUGEN		(1 << 0)
+#define DHCSR_C_HALT		(1 << 1)
+#define DHCSR_C_STEP		(1 << 2)
+#define DHCSR_C_MASKINTS	(1 << 3)
+#define DHCSR_S_REGRDY		(1 << 16)
+#define DHCSR_S_HALT		(1 << 17)
+#define DHCSR_S_RETIRE_ST	(1 << 24)
+#define DHCSR_S_RESET_ST	(1 << 25)
+#define DHCSR_DBGKEY		0xA05F
+
+#define DFSR_HALTED		(1 << 0)
+#define DFSR_BKPT		(1 << 1)
+#define DFSR_VCATCH		(1 << 3)
+
+#define AIRCR_VECTKEY		0x05FA
+#define AIRCR_VECTRESET		(1 << 0)
+#define AIRCR_SYSRESETREQ	(1 << 2)
+
+#define DEMCR_VC_CORERESET	(1 << 0)
+
+#define DCRSR_WNR		(1 << 16)
+
+/* how far a resumed core looks for somewhere to stop */
+#define DUMMY_RUN_LIMIT		0x10000
+
+#define DUMMY_NUM_CORE_REGS	0x20
+
+struct dummy_core {
+	/// r0-r15, xPSR, MSP, PSP and the special registers, by DCRSR number
+	uint32_t regs[DUMMY_NUM_CORE_REGS];
+	/// the C_* bits last written to DHCSR
+	uint32_t dhcsr;
+	bool halted;
+	/// sticky status, cleared when DHCSR is read
+	bool reset_st, retire_st;
+	bool srst;
+};
+
+static struct dummy_core dummy_core;
+static uint8_t *dummy_ppb;
+
+/// What the simulated chain has seen since the stats were last reset.
+struct dummy_stats {
+	/// execute_queue calls, i.e. USB round trips on a real adapter
+	unsigned long flushes;
+	unsigned long long cycles;
+	unsigned long long ir_bits, dr_bits;
+	unsigned long dp_transactions, ap_transactions;
+	/// MEM-AP DRW and BDx transfers
+	unsigned long memory_accesses;
+};
+
+static struct dummy_stats dummy_stats;
+
+
+static uint32_t dummy_ppb_get(uint32_t address)
+{
+	return le_to_h_u32(dummy_ppb + address - PPB_BASE);
+}
+
+static void dummy_ppb_set(uint32_t address, uint32_t value)
+{
+	h_u32_to_le(dummy_ppb + address - PPB_BASE, value);
+}
+
+static struct dummy_memory *dummy_find_memory(uint32_t address)
+{
+	struct dummy_memory *mem;
+
+	for (mem = dummy_memories; mem; mem = mem->next)
+	{
+		if (address >= mem->base && address - mem->base < mem->size)
+			return mem;
+	}
+	return NULL;
+}
+
+static void dummy_core_reset(void);
+
+static bool dummy_read_word(uint32_t address, uint32_t *value);
+
+static uint32_t dummy_ppb_read(uint32_t address)
+{
+	uint32_t value;
+
+	switch (address)
+	{
+	case PPB_DHCSR:
+		value = dummy_core.dhcsr | DHCSR_S_REGRDY;
+		if (dummy_core.halted)
+			value |= DHCSR_S_HALT;
+		if (dummy_core.retire_st || !dummy_core.halted)
+			value |= DHCSR_S_RETIRE_ST;
+		if (dummy_core.reset_st)
+			value |= DHCSR_S_RESET_ST;
+		dummy_core.retire_st = false;
+		dummy_core.reset_st = false;
+		return value;
+	case PPB_AIRCR:
+		return (0xFA05 << 16) | (dummy_ppb_get(address) & 0x700);
+	case PPB_DWT_PCSR:
+		return dummy_core.halted ? 0xFFFFFFFF : dummy_core.regs[15];
+	default:
+		return dummy_ppb_get(address);
+	}
+}
+
+static bool dummy_fpb_match(uint32_t address)
+{
+	unsigned i;
+
+	if (!(dummy_ppb_get(PPB_FP_CTRL) & 1))
+		return false;
+
+	for (i = 0; i < PPB_FP_NUM_CODE; i++)
+	{
+		uint32_t comp = dummy_ppb_get(PPB_FP_COMP0 + 4 * i);
+		unsigned replace = comp >> 30;
+
+		if (!(comp & 1) || (comp & 0x1FFFFFFC) != (address & ~3))
+			continue;
+		if ((address & 2) ? (replace & 2) : (replace & 1))
+			return true;
+	}
+	return false;
+}
+
+static void dummy_core_halt(uint32_t reason)
+{
+	dummy_core.halted = true;
+	dummy_ppb_set(PPB_DFSR, dummy_ppb_get(PPB_DFSR) | reason);
+}
+
+static void dummy_core_run(void)
+{
+	uint32_t pc = dummy_core.regs[15] & ~1;
+	uint32_t offset;
+
+	dummy_core.halted = false;
+	dummy_core.retire_st = true;
+
+	for (offset = 0; offset < DUMMY_RUN_LIMIT; offset += 2)
+	{
+		uint32_t address = pc + offset;
+		uint32_t word;
+
+		if (!dummy_read_word(address, &word))
+			break;
+		if (dummy_fpb_match(address)
+				|| (((word >> (8 * (address & 2))) & 0xFF00) == 0xBE00))
+		{
+			dummy_core.regs[15] = address;
+			dummy_core_halt(DFSR_BKPT);
+			break;
+		}
+	}
+}
+
+static void dummy_ppb_write(uint32_t address, uint32_t value)
+{
+	unsigned regsel;
+
+	/* ID registers and the ROM table are read-only */
+	if (address == PPB_CPUID || (address & 0xFFF) >= 0xFD0
+			|| (address & ~0xFFF) == PPB_ROM_TABLE)
+		return;
+
+	switch (address)
+	{
+	case PPB_DHCSR:
+		if ((value >> 16) != DHCSR_DBGKEY)
+			break;
+		dummy_core.dhcsr = value & (DHCSR_C_DEBUGEN | DHCSR_C_HALT
+				| DHCSR_C_STEP | DHCSR_C_MASKINTS);
+		if (!(value & DHCSR_C_DEBUGEN))
+			break;
+		if (value & DHCSR_C_HALT)
+		{
+			if (!dummy_core.halted)
+				dummy_core_halt(DFSR_HALTED);
+		}
+		else if (dummy_core.halted)
+		{
+			if (value & DHCSR_C_STEP)
+			{
+				dummy_core.regs[15] += 2;
+				dummy_core.retire_st = true;
+				dummy_core_halt(DFSR_HALTED);
+			}
+			else
+				dummy_core_run();
+		}
+		break;
+	case PPB_DCRSR:
+		regsel = value & 0x7F;
+		if (!dummy_core.halted || regsel >= DUMMY_NUM_CORE_REGS)
+			break;
+		if (value & DCRSR_WNR)
+			dummy_core.regs[regsel] = dummy_ppb_get(PPB_DCRDR);
+		else
+			dummy_ppb_set(PPB_DCRDR, dummy_core.regs[regsel]);
+		break;
+	case PPB_DFSR:
+		dummy_ppb_set(address, dummy_ppb_get(address) & ~value);
+		break;
+	case PPB_AIRCR:
+		if ((value >> 16) != AIRCR_VECTKEY)
+			break;
+		dummy_ppb_set(address, value & 0x700);
+		if (value & (AIRCR_SYSRESETREQ | AIRCR_VECTRESET))
+			dummy_core_reset();
+		break;
+	case PPB_FP_CTRL:
+		/* KEY must be set for the write to take effect */
+		if (value & 2)
+			dummy_ppb_set(address, (dummy_ppb_get(address) & ~1)
+					| (value & 1));
+		break;
+	case PPB_DWT_CTRL:
+		dummy_ppb_set(address, (dummy_ppb_get(address) & 0xF0000000)
+				| (value & 0x0FFFFFFF));
+		break;
+	case PPB_DWT_PCSR:
+		break;
+	default:
+		dummy_ppb_set(address, value);
+		break;
+	}
+}
+
+static bool dummy_read_word(uint32_t address, uint32_t *value)
+{
+	struct dummy_memory *mem;
+
+	address &= ~3;
+	if (address >= PPB_BASE && address - PPB_BASE < PPB_SIZE)
+	{
+		*value = dummy_ppb_read(address);
+		return true;
+	}
+
+	mem = dummy_find_memory(address);
+	if (!mem)
+		return false;
+	*value = le_to_h_u32(mem->data + address - mem->base);
+	return true;
+}
+
+/* write the byte lanes set in @a lanes */
+static bool dummy_write_word(uint32_t address, uint32_t value, uint32_t lanes)
+{
+	struct dummy_memory *mem;
+	uint32_t old;
+
+	address &= ~3;
+	if (address >= PPB_BASE && address - PPB_BASE < PPB_SIZE)
+	{
+		old = dummy_ppb_get(address);
+		dummy_ppb_write(address, (old & ~lanes) | (value & lanes));
+		return true;
+	}
+
+	mem = dummy_find_memory(address);
+	if (!mem)
+		return false;
+	old = le_to_h_u32(mem->data + address - mem->base);
+	h_u32_to_le(mem->data + address - mem->base,
+			(old & ~lanes) | (value & lanes));
+	return true;
+}
+
+static void dummy_core_reset(void)
+{
+	uint32_t value;
+
+	memset(dummy_core.regs, 0, sizeof(dummy_core.regs));
+	if (dummy_read_word(0, &value))
+		dummy_core.regs[13] = value;
+	if (dummy_read_word(4, &value))
+		dummy_core.regs[15] = value & ~1;
+	dummy_core.regs[16] = 1 << 24;		/* xPSR: Thumb */
+	dummy_core.reset_st = true;
+
+	if ((dummy_core.dhcsr & DHCSR_C_DEBUGEN)
+			&& ((dummy_ppb_get(PPB_DEMCR) & DEMCR_VC_CORERESET)
+				|| (dummy_core.dhcsr & DHCSR_C_HALT)))
+	{
+		dummy_core.halted = false;
+		dummy_core_halt(DFSR_VCATCH);
+	}
+	else
+		dummy_core_run();
+}
+
+static void dummy_ppb_init(void)
+{
+	static const uint8_t cid[] = { 0x0D, 0xE0, 0x05, 0xB1 };
+	static const struct {
+		uint32_t base;
+		uint8_t pid0, pid2;
+	} components[] = {
+		{ 0xE0000000, 0x01, 0x3B },	/* ITM */
+		{ 0xE0001000, 0x02, 0x3B },	/* DWT */
+		{ 0xE0002000, 0x03, 0x2B },	/* FPB */
+		{ 0xE000E000, 0x00, 0x0B },	/* SCS */
+	};
+	unsigned i, j;
+
+	for (i = 0; i < ARRAY_SIZE(components); i++)
+	{
+		uint32_t base = components[i].base;
+
+		dummy_ppb_set(base + 0xFD0, 0x04);
+		dummy_ppb_set(base + 0xFE0, components[i].pid0);
+		dummy_ppb_set(base + 0xFE4, 0xB0);
+		dummy_ppb_set(base + 0xFE8, components[i].pid2);
+		for (j = 0; j < ARRAY_SIZE(cid); j++)
+			dummy_ppb_set(base + 0xFF0 + 4 * j, cid[j]);
+
+		/* ROM table entry, as an offset from the table */
+		dummy_ppb_set(PPB_ROM_TABLE + 4 * i,
+				(base - PPB_ROM_TABLE) | 0x3);
+	}
+
+	/* the ROM table is a class 1 component */
+	dummy_ppb_set(PPB_ROM_TABLE + 0xFD0, 0x04);
+	dummy_ppb_set(PPB_ROM_TABLE + 0xFE4, 0xB4);
+	dummy_ppb_set(PPB_ROM_TABLE + 0xFE8, 0x0B);
+	for (j = 0; j < ARRAY_SIZE(cid); j++)
+		dummy_ppb_set(PPB_ROM_TABLE + 0xFF0 + 4 * j,
+				j == 1 ? 0x10 : cid[j]);
+
+	dummy_ppb_set(PPB_CPUID, 0x412FC230);	/* Cortex-M3 r2p0 */
+	dummy_ppb_set(PPB_DWT_CTRL, 4 << 28);
+	dummy_ppb_set(PPB_FP_CTRL, (2 << 8) | (PPB_FP_NUM_CODE << 4));
+
+	dummy_core.dhcsr = 0;
+	dummy_core_reset();
+	dummy_core.reset_st = false;
+}
+
+static void dummy_mem_ap_access(unsigned reg, bool read, uint32_t data)
+{
+	uint32_t address, lanes;
+	unsigned size;
+
+	switch (reg)
+	{
+	case 0x00:	/* CSW */
+		if (read)
+			dummy_dap.read_result = dummy_dap.csw | AP_CSW_DEVICEEN;
+		else
+			dummy_dap.csw = data & ~(AP_CSW_DEVICEEN | (1 << 7));
+		return;
+	case 0x04:	/* TAR */
+		if (read)
+			dummy_dap.read_result = dummy_dap.tar;
+		else
+			dummy_dap.tar = data;
+		return;
+	case 0x0C:	/* DRW */
+		address = dummy_dap.tar;
+		size = 1 << (dummy_dap.csw & AP_CSW_SIZE_MASK);
+		if (size > 4)
+		{
+			dummy_dap.ctrl_stat |= DP_STICKYERR;
+			return;
+		}
+		break;
+	case 0x10:	/* BD0-BD3 */
+	case 0x14:
+	case 0x18:
+	case 0x1C:
+		address = (dummy_dap.tar & ~0xF) | (reg & 0xC);
+		size = 4;
+		break;
+	case 0xF4:	/* CFG: little endian */
+		if (read)
+			dummy_dap.read_result = 0;
+		return;
+	case 0xF8:	/* BASE */
+		if (read)
+			dummy_dap.read_result = AP_BASE_VALUE;
+		return;
+	case 0xFC:	/* IDR */
+		if (read)
+			dummy_dap.read_result = AP_IDR_VALUE;
+		return;
+	default:
+		if (read)
+			dummy_dap.read_result = 0;
+		return;
+	}
+
+	dummy_stats.memory_accesses++;
+
+	if (read)
+	{
+		if (!dummy_read_word(address, &dummy_dap.read_result))
+		{
+			dummy_dap.read_result = 0;
+			dummy_dap.ctrl_stat |= DP_STICKYERR;
+		}
+	}
+	else
+	{
+		lanes = (size == 4) ? 0xFFFFFFFF
+				: ((1u << (8 * size)) - 1) << (8 * (address & 3));
+		if (!dummy_write_word(address, data, lanes))
+			dummy_dap.ctrl_stat |= DP_STICKYERR;
+	}
+
+	/* auto-increment stays within a 1 KB block, as on real MEM-APs */
+	if (reg == 0x0C && (dummy_dap.csw & AP_CSW_ADDRINC_MASK))
+		dummy_dap.tar = (dummy_dap.tar & ~0x3FF)
+				| ((dummy_dap.tar + size) & 0x3FF);
+}
+
+/* apply a DPACC or APACC scan, at Update-DR */
+static void dummy_dap_update(struct dummy_tap *tap)
+{
+	bool read = tap->dr_shift & 1;
+	unsigned reg = ((tap->dr_shift >> 1) & 0x3) << 2;
+	uint32_t data = tap->dr_shift >> 3;
+
+	if (tap->ir == DAP_IR_DPACC)
+	{
+		dummy_stats.dp_transactions++;
+		switch (reg)
+		{
+		case 0x4:	/* CTRL/STAT; power up requests are acked at once */
+			if (read)
+				dummy_dap.read_result = dummy_dap.ctrl_stat
+					| ((dummy_dap.ctrl_stat
+						& (DP_CDBGPWRUPREQ | DP_CSYSPWRUPREQ)) << 1);
+			else
+			{
+				uint32_t sticky = DP_STICKYORUN | DP_STICKYCMP | DP_STICKYERR;
+				dummy_dap.ctrl_stat = (dummy_dap.ctrl_stat & sticky & ~data)
+					| (data & ~sticky & 0x5FFFFFFF);
+			}
+			break;
+		case 0x8:	/* SELECT */
+			if (read)
+				dummy_dap.read_result = dummy_dap.select;
+			else
+				dummy_dap.select = data;
+			break;
+		case 0xC:	/* RDBUFF: the result of the last read stays put */
+			break;
+		default:
+			if (read)
+				dummy_dap.read_result = 0;
+			break;
+		}
+	}
+	else if (tap->ir == DAP_IR_APACC)
+	{
+		dummy_stats.ap_transactions++;
+
+		/* APACC accesses are discarded while a sticky error is set */
+		if (dummy_dap.ctrl_stat & DP_STICKYERR)
+			return;
+
+		if ((dummy_dap.select >> 24) != 0)
+		{
+			if (read)
+				dummy_dap.read_result = 0;
+			return;
+		}
+
+		dummy_mem_ap_access((dummy_dap.select & 0xF0) | reg, read, data);
+	}
+}
+
+static void dummy_tap_capture_dr(struct dummy_tap *tap)
+{
+	uint32_t bypass = ((uint64_t)1 << tap->ir_len) - 1;
+
+	if (tap->dap && (tap->ir == DAP_IR_DPACC || tap->ir == DAP_IR_APACC
+				|| tap->ir == DAP_IR_ABORT))
+	{
+		tap->dr_len = 35;
+		tap->dr_shift = ((uint64_t)dummy_dap.read_result << 3)
+				| DAP_ACK_OK_FAULT;
+	}
+	else if (tap->idcode && (tap->dap ? tap->ir == DAP_IR_IDCODE
+				: tap->ir != bypass))
+	{
+		tap->dr_len = 32;
+		tap->dr_shift = tap->idcode;
+	}
+	else
+	{
+		tap->dr_len = 1;
+		tap->dr_shift = 0;
+	}
+}
+
+static void dummy_chain_shift(bool ir, int tdi)
+{
+	unsigned i;
+
+	for (i = 0; i < dummy_num_taps; i++)
+	{
+		struct dummy_tap *tap = dummy_taps + i;
+		unsigned len = ir ? tap->ir_len : tap->dr_len;
+		uint64_t *reg = ir ? &tap->ir_shift : &tap->dr_shift;
+		int in;
+
+		if (i + 1 < dummy_num_taps)
+			in = ir ? (tap[1].ir_shift & 1) : (tap[1].dr_shift & 1);
+		else
+			in = tdi;
+
+		*reg = (*reg >> 1) | ((uint64_t)in << (len - 1));
+	}
+}
+
+/* a rising TCK edge, in @a state, before the state transition */
+static void dummy_chain_clock(tap_state_t state, int tdi)
+{
+	unsigned i;
+
+	dummy_stats.cycles++;
+
+	switch (state)
+	{
+	case TAP_IRCAPTURE:
+		for (i = 0; i < dummy_num_taps; i++)
+			dummy_taps[i].ir_shift = 0x1;
+		break;
+	case TAP_DRCAPTURE:
+		for (i = 0; i < dummy_num_taps; i++)
+			dummy_tap_capture_dr(dummy_taps + i);
+		break;
+	case TAP_IRSHIFT:
+		dummy_stats.ir_bits++;
+		dummy_chain_shift(true, tdi);
+		break;
+	case TAP_DRSHIFT:
+		dummy_stats.dr_bits++;
+		dummy_chain_shift(false, tdi);
+		break;
+	default:
+		break;
+	}
+}
+
+/* entered @a state, after a rising TCK edge */
+static void dummy_chain_enter(tap_state_t state)
+{
+	unsigned i;
+
+	for (i = 0; i < dummy_num_taps; i++)
+	{
+		struct dummy_tap *tap = dummy_taps + i;
+
+		switch (state)
+		{
+		case TAP_RESET:
+			tap->ir = tap->dap ? DAP_IR_IDCODE : 0;
+			break;
+		case TAP_IRUPDATE:
+			tap->ir = tap->ir_shift & (((uint64_t)1 << tap->ir_len) - 1);
+			break;
+		case TAP_DRUPDATE:
+			if (tap->dap && tap->dr_len == 35)
+				dummy_dap_update(tap);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+
 static int dummy_read(void)
 {
+	if (dummy_num_taps)
+	{
+		if (dummy_state == TAP_IRSHIFT)
+			return dummy_taps[0].ir_shift & 1;
+		if (dummy_state == TAP_DRSHIFT)
+			return dummy_taps[0].dr_shift & 1;
+		return 1;
+	}
+
 	int data = 1 & dummy_data;
 	dummy_data = (dummy_data >> 1) | (1 << 31);
 	return data;
@@ -52,6 +733,10 @@ static void dummy_write(int tck, int tms, int tdi)
 		if (tck)
 		{
 			tap_state_t old_state = dummy_state;
+
+			if (dummy_num_taps)
+				dummy_chain_clock(old_state, tdi);
+
 			dummy_state = tap_state_transition(old_state, tms);
 
 			if (old_state != dummy_state)
@@ -64,6 +749,9 @@ static void dummy_write(int tck, int tms, int tdi)
 
 				LOG_DEBUG("dummy_tap: %s", tap_state_name(dummy_state));
 
+				if (dummy_num_taps)
+					dummy_chain_enter(dummy_state);
+
 #if defined(DEBUG)
 				if (dummy_state == TAP_DRCAPTURE)
 					dummy_data = 0x01255043;
@@ -86,7 +774,23 @@ static void dummy_reset(int trst, int srst)
 	dummy_clock = 0;
 
 	if (trst || (srst && (jtag_get_reset_config() & RESET_SRST_PULLS_TRST)))
+	{
 		dummy_state = TAP_RESET;
+		if (dummy_num_taps)
+			dummy_chain_enter(TAP_RESET);
+	}
+
+	/* the core comes out of reset when SRST is released */
+	if (dummy_ppb)
+	{
+		if (srst)
+			dummy_core.srst = true;
+		else if (dummy_core.srst)
+		{
+			dummy_core.srst = false;
+			dummy_core_reset();
+		}
+	}
 
 	LOG_DEBUG("reset to: %s", tap_state_name(dummy_state));
 }
@@ -103,6 +807,12 @@ static struct bitbang_interface dummy_bitbang = {
 	};
 
 
+static int dummy_execute_queue(void)
+{
+	dummy_stats.flushes++;
+	return bitbang_execute_queue();
+}
+
 static int dummy_khz(int khz, int *jtag_speed)
 {
 	if (khz == 0)
@@ -135,31 +845,211 @@ static int dummy_speed(int speed)
 	return ERROR_OK;
 }
 
+static int dummy_add_memory(uint32_t base, uint32_t size)
+{
+	struct dummy_memory *mem;
+
+	mem = calloc(1, sizeof(*mem));
+	if (!mem)
+		return ERROR_FAIL;
+	mem->data = calloc(1, size);
+	if (!mem->data)
+	{
+		free(mem);
+		return ERROR_FAIL;
+	}
+	mem->base = base;
+	mem->size = size;
+	mem->next = dummy_memories;
+	dummy_memories = mem;
+
+	return ERROR_OK;
+}
+
 static int dummy_init(void)
 {
+	unsigned i;
+
 	bitbang_interface = &dummy_bitbang;
 
+	for (i = 0; i < dummy_num_taps; i++)
+	{
+		if (!dummy_taps[i].dap)
+			continue;
+
+		/* default to 64 KB of SRAM where Cortex-M parts have it */
+		if (!dummy_memories
+				&& dummy_add_memory(0x20000000, 64 * 1024) != ERROR_OK)
+			return ERROR_FAIL;
+
+		dummy_ppb = calloc(1, PPB_SIZE);
+		if (!dummy_ppb)
+			return ERROR_FAIL;
+		dummy_ppb_init();
+		break;
+	}
+
+	dummy_chain_enter(TAP_RESET);
+
 	return ERROR_OK;
 }
 
 static int dummy_quit(void)
 {
+	while (dummy_memories)
+	{
+		struct dummy_memory *mem = dummy_memories;
+		dummy_memories = mem->next;
+		free(mem->data);
+		free(mem);
+	}
+
+	free(dummy_ppb);
+	dummy_ppb = NULL;
+
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(dummy_handle_tap_command)
+{
+	struct dummy_tap *tap;
+	unsigned ir_len;
+	uint32_t idcode;
+	bool dap = false;
+
+	if (CMD_ARGC != 2)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (dummy_num_taps == DUMMY_MAX_TAPS)
+	{
+		LOG_ERROR("at most %d simulated TAPs", DUMMY_MAX_TAPS);
+		return ERROR_FAIL;
+	}
+
+	if (strcmp(CMD_ARGV[0], "dap") == 0)
+	{
+		unsigned i;
+
+		for (i = 0; i < dummy_num_taps; i++)
+		{
+			if (dummy_taps[i].dap)
+			{
+				LOG_ERROR("only one simulated DAP is supported");
+				return ERROR_FAIL;
+			}
+		}
+		dap = true;
+		ir_len = 4;
+	}
+	else
+	{
+		COMMAND_PARSE_NUMBER(uint, CMD_ARGV[0], ir_len);
+		if (ir_len < 2 || ir_len > 32)
+		{
+			LOG_ERROR("IR length must be 2..32 bits");
+			return ERROR_COMMAND_SYNTAX_ERROR;
+		}
+	}
+
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[1], idcode);
+
+	tap = dummy_taps + dummy_num_taps++;
+	memset(tap, 0, sizeof(*tap));
+	tap->ir_len = ir_len;
+	tap->dap = dap;
+	tap->idcode = idcode;
+
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(dummy_handle_memory_command)
+{
+	uint32_t base, size;
+
+	if (CMD_ARGC != 2)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], base);
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[1], size);
+	if ((base | size) & 3 || size == 0)
+	{
+		LOG_ERROR("memory must be a non-empty, word aligned region");
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	}
+
+	return dummy_add_memory(base, size);
+}
+
+COMMAND_HANDLER(dummy_handle_stats_command)
+{
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (CMD_ARGC == 1)
+	{
+		if (strcmp(CMD_ARGV[0], "reset") != 0)
+			return ERROR_COMMAND_SYNTAX_ERROR;
+		memset(&dummy_stats, 0, sizeof(dummy_stats));
+		return ERROR_OK;
+	}
+
+	command_print(CMD_CTX, "%lu flushes, %llu TCK cycles, "
+			"%llu IR bits and %llu DR bits shifted",
+			dummy_stats.flushes, dummy_stats.cycles,
+			dummy_stats.ir_bits, dummy_stats.dr_bits);
+	command_print(CMD_CTX, "%lu DP and %lu AP transactions, "
+			"%lu of them memory transfers",
+			dummy_stats.dp_transactions, dummy_stats.ap_transactions,
+			dummy_stats.memory_accesses);
+
 	return ERROR_OK;
 }
 
+static const struct command_registration dummy_subcommand_handlers[] = {
+	{
+		.name = "tap",
+		.handler = dummy_handle_tap_command,
+		.mode = COMMAND_CONFIG,
+		.help = "Add a simulated TAP to the scan chain, nearest TDO "
+			"first.  'dap' adds an ADIv5 JTAG-DP with a MEM-AP "
+			"and Cortex-M debug registers behind it.",
+		.usage = "('dap'|ir_length) idcode",
+	},
+	{
+		.name = "memory",
+		.handler = dummy_handle_memory_command,
+		.mode = COMMAND_CONFIG,
+		.help = "Add a region of RAM behind the simulated MEM-AP.",
+		.usage = "address size",
+	},
+	{
+		.name = "stats",
+		.handler = dummy_handle_stats_command,
+		.mode = COMMAND_EXEC,
+		.help = "Display the JTAG traffic the simulated scan chain "
+			"has seen, or reset the counts.",
+		.usage = "['reset']",
+	},
+	{
+		.chain = hello_command_handlers,
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
 static const struct command_registration dummy_command_handlers[] = {
 	{
 		.name = "dummy",
 		.mode = COMMAND_ANY,
 		.help = "dummy interface driver commands",
 
-		.chain = hello_command_handlers,
+		.chain = dummy_subcommand_handlers,
 	},
 	COMMAND_REGISTRATION_DONE,
 };
 
 /* The dummy driver is used to easily check the code path
- * where the target is unresponsive.
+ * where the target is unresponsive, or, given a simulated
+ * scan chain, to exercise the upper layers without hardware.
  */
 struct jtag_interface dummy_interface = {
 		.name = "dummy",
@@ -168,7 +1058,7 @@ struct jtag_interface dummy_interface = {
 		.commands = dummy_command_handlers,
 		.transports = jtag_only,
 
-		.execute_queue = &bitbang_execute_queue,
+		.execute_queue = &dummy_execute_queue,
 
 		.speed = &dummy_speed,
 		.khz = &dummy_khz,
@@ -83,6 +83,7 @@
 #include <jtag/interface.h>
 #include <jtag/transport.h>
 #include <helper/time_support.h>
+#include <helper/perf.h>
 
 #if IS_CYGWIN == 1
 #include <windows.h>
@@ -374,6 +375,25 @@ static int             ft2232_buffer_size  = 0;
 static int             ft2232_read_pointer = 0;
 static int             ft2232_expect_read  = 0;
 
+/* data read back from the FT2232, consumed by buffer_read() */
+static uint8_t*             ft2232_rx_buffer = NULL;
+static int             ft2232_rx_size = 0;
+
+/*
+ * Pipelined mode: when the queue is flushed part way through, the
+ * MPSSE commands just written are left running on the adapter while
+ * the next batch is built in the other buffer.  Their TDO data is only
+ * read back when the next batch is ready to go, or at the end of the
+ * queue; so at most one batch is ever in flight, as before.
+ */
+static bool            ft2232_pipeline = false;
+static uint8_t*             ft2232_buffers[2];
+static bool            ft2232_pending = false;
+static uint8_t*             ft2232_pending_buffer;
+static int             ft2232_pending_expect_read;
+static struct jtag_command* ft2232_pending_first;
+static struct jtag_command* ft2232_pending_last;
+
 /**
  * Function buffer_write
  * writes a byte into the byte buffer, "ft2232_buffer", which must be sent later.
@@ -392,9 +412,9 @@ static inline void buffer_write(uint8_t val)
  */
 static inline uint8_t buffer_read(void)
 {
-	assert(ft2232_buffer);
-	assert(ft2232_read_pointer < ft2232_buffer_size);
-	return ft2232_buffer[ft2232_read_pointer++];
+	assert(ft2232_rx_buffer);
+	assert(ft2232_read_pointer < ft2232_rx_size);
+	return ft2232_rx_buffer[ft2232_read_pointer++];
 }
 
 /**
@@ -518,6 +538,9 @@ static int ft2232_write(uint8_t* buf, int size, uint32_t* bytes_written)
 	}
 #endif
 
+	perf_count(PERF_ADAPTER_WRITES, 1);
+	perf_count(PERF_ADAPTER_BYTES_OUT, *bytes_written);
+
 	if (*bytes_written != (uint32_t)size)
 	{
 		return ERROR_JTAG_DEVICE_ERROR;
@@ -564,6 +587,9 @@ static int ft2232_read(uint8_t* buf, uint32_t size, uint32_t* bytes_read)
 
 #endif
 
+	perf_count(PERF_ADAPTER_READS, 1);
+	perf_count(PERF_ADAPTER_BYTES_IN, *bytes_read);
+
 	if (*bytes_read < size)
 	{
 		LOG_ERROR("couldn't read enough bytes from "
@@ -758,15 +784,15 @@ static void ft2232_read_scan(enum scan_type type, uint8_t* buffer, int scan_size
 	buffer[cur_byte] = (buffer[cur_byte] | (((buffer_read()) << 1) & 0x80)) >> (8 - bits_left);
 }
 
-static void ft2232_debug_dump_buffer(void)
+static void ft2232_debug_dump_buffer(const uint8_t *buffer, int size)
 {
 	int i;
 	char line[256];
 	char* line_p = line;
 
-	for (i = 0; i < ft2232_buffer_size; i++)
+	for (i = 0; i < size; i++)
 	{
-		line_p += snprintf(line_p, sizeof(line) - (line_p - line), "%2.2x ", ft2232_buffer[i]);
+		line_p += snprintf(line_p, sizeof(line) - (line_p - line), "%2.2x ", buffer[i]);
 		if (i % 16 == 15)
 		{
 			LOG_DEBUG("%s", line);
@@ -778,51 +804,37 @@ static void ft2232_debug_dump_buffer(void)
 		LOG_DEBUG("%s", line);
 }
 
-static int ft2232_send_and_recv(struct jtag_command* first, struct jtag_command* last)
+/**
+ * Reads back the TDO data of the batch sent by ft2232_send(), if any,
+ * and hands it to the scan commands of that batch.
+ */
+static int ft2232_recv_pending(void)
 {
 	struct jtag_command* cmd;
 	uint8_t* buffer;
 	int scan_size;
 	enum scan_type  type;
 	int retval;
-	uint32_t bytes_written = 0;
 	uint32_t bytes_read = 0;
 
 #ifdef _DEBUG_USB_IO_
-	struct timeval  start, inter, inter2, end;
-	struct timeval  d_inter, d_inter2, d_end;
+	struct timeval  start, end, d_end;
 #endif
 
-#ifdef _DEBUG_USB_COMMS_
-	LOG_DEBUG("write buffer (size %i):", ft2232_buffer_size);
-	ft2232_debug_dump_buffer();
-#endif
-
-#ifdef _DEBUG_USB_IO_
-	gettimeofday(&start, NULL);
-#endif
-
-	if ((retval = ft2232_write(ft2232_buffer, ft2232_buffer_size, &bytes_written)) != ERROR_OK)
-	{
-		LOG_ERROR("couldn't write MPSSE commands to FT2232");
-		return retval;
-	}
-
-#ifdef _DEBUG_USB_IO_
-	gettimeofday(&inter, NULL);
-#endif
+	if (!ft2232_pending)
+		return ERROR_OK;
+	ft2232_pending = false;
 
-	if (ft2232_expect_read)
+	if (ft2232_pending_expect_read)
 	{
 		/* FIXME this "timeout" is never changed ... */
 		int timeout = LIBFTDI_READ_RETRY_COUNT;
-		ft2232_buffer_size = 0;
 
 #ifdef _DEBUG_USB_IO_
-		gettimeofday(&inter2, NULL);
+		gettimeofday(&start, NULL);
 #endif
 
-		if ((retval = ft2232_read(ft2232_buffer, ft2232_expect_read, &bytes_read)) != ERROR_OK)
+		if ((retval = ft2232_read(ft2232_pending_buffer, ft2232_pending_expect_read, &bytes_read)) != ERROR_OK)
 		{
 			LOG_ERROR("couldn't read from FT2232");
 			return retval;
@@ -830,28 +842,21 @@ static int ft2232_send_and_recv(struct jtag_command* first, struct jtag_command*
 
 #ifdef _DEBUG_USB_IO_
 		gettimeofday(&end, NULL);
-
-		timeval_subtract(&d_inter, &inter, &start);
-		timeval_subtract(&d_inter2, &inter2, &start);
 		timeval_subtract(&d_end, &end, &start);
 
-		LOG_INFO("inter: %u.%06u, inter2: %u.%06u end: %u.%06u",
-			(unsigned)d_inter.tv_sec, (unsigned)d_inter.tv_usec,
-			(unsigned)d_inter2.tv_sec, (unsigned)d_inter2.tv_usec,
+		LOG_INFO("read: %u.%06u",
 			(unsigned)d_end.tv_sec, (unsigned)d_end.tv_usec);
 #endif
 
-		ft2232_buffer_size = bytes_read;
-
-		if (ft2232_expect_read != ft2232_buffer_size)
+		if (ft2232_pending_expect_read != (int)bytes_read)
 		{
 			LOG_ERROR("ft2232_expect_read (%i) != "
 					"ft2232_buffer_size (%i) "
 					"(%i retries)",
-					ft2232_expect_read,
-					ft2232_buffer_size,
+					ft2232_pending_expect_read,
+					(int)bytes_read,
 					LIBFTDI_READ_RETRY_COUNT - timeout);
-			ft2232_debug_dump_buffer();
+			ft2232_debug_dump_buffer(ft2232_pending_buffer, bytes_read);
 
 			exit(-1);
 		}
@@ -859,12 +864,13 @@ static int ft2232_send_and_recv(struct jtag_command* first, struct jtag_command*
 #ifdef _DEBUG_USB_COMMS_
 		LOG_DEBUG("read buffer (%i retries): %i bytes",
 				LIBFTDI_READ_RETRY_COUNT - timeout,
-				ft2232_buffer_size);
-		ft2232_debug_dump_buffer();
+				(int)bytes_read);
+		ft2232_debug_dump_buffer(ft2232_pending_buffer, bytes_read);
 #endif
 	}
 
-	ft2232_expect_read  = 0;
+	ft2232_rx_buffer = ft2232_pending_buffer;
+	ft2232_rx_size = bytes_read;
 	ft2232_read_pointer = 0;
 
 	/* return ERROR_OK, unless a jtag_read_buffer returns a failed check
@@ -872,8 +878,8 @@ static int ft2232_send_and_recv(struct jtag_command* first, struct jtag_command*
 	 */
 	retval = ERROR_OK;
 
-	cmd = first;
-	while (cmd != last)
+	cmd = ft2232_pending_first;
+	while (cmd != ft2232_pending_last)
 	{
 		switch (cmd->type)
 		{
@@ -897,11 +903,61 @@ static int ft2232_send_and_recv(struct jtag_command* first, struct jtag_command*
 		cmd = cmd->next;
 	}
 
-	ft2232_buffer_size = 0;
+	ft2232_rx_buffer = NULL;
+	ft2232_rx_size = 0;
 
 	return retval;
 }
 
+/**
+ * Writes the MPSSE commands built for the commands from @a first up to
+ * (not including) @a last, without waiting for their TDO data.  Any
+ * earlier batch still in flight is read back first.  In pipelined mode
+ * the next batch is then built in the other buffer.
+ */
+static int ft2232_send(struct jtag_command* first, struct jtag_command* last)
+{
+	int retval;
+	int recv_retval;
+	uint32_t bytes_written = 0;
+
+	recv_retval = ft2232_recv_pending();
+
+#ifdef _DEBUG_USB_COMMS_
+	LOG_DEBUG("write buffer (size %i):", ft2232_buffer_size);
+	ft2232_debug_dump_buffer(ft2232_buffer, ft2232_buffer_size);
+#endif
+
+	if ((retval = ft2232_write(ft2232_buffer, ft2232_buffer_size, &bytes_written)) != ERROR_OK)
+	{
+		LOG_ERROR("couldn't write MPSSE commands to FT2232");
+		return retval;
+	}
+
+	ft2232_pending = true;
+	ft2232_pending_buffer = ft2232_buffer;
+	ft2232_pending_expect_read = ft2232_expect_read;
+	ft2232_pending_first = first;
+	ft2232_pending_last = last;
+
+	if (ft2232_pipeline && ft2232_buffers[1])
+		ft2232_buffer = (ft2232_buffer == ft2232_buffers[0])
+				? ft2232_buffers[1] : ft2232_buffers[0];
+
+	ft2232_buffer_size = 0;
+	ft2232_expect_read = 0;
+
+	return recv_retval;
+}
+
+static int ft2232_send_and_recv(struct jtag_command* first, struct jtag_command* last)
+{
+	int retval = ft2232_send(first, last);
+	int recv_retval = ft2232_recv_pending();
+
+	return (retval != ERROR_OK) ? retval : recv_retval;
+}
+
 /**
  * Function ft2232_add_pathmove
  * moves the TAP controller from the current state to a new state through the
@@ -1900,6 +1956,9 @@ static int ft2232_execute_scan(struct jtag_command *cmd)
 		if (first_unsent != cmd)
 			if (ft2232_send_and_recv(first_unsent, cmd) != ERROR_OK)
 				retval = ERROR_JTAG_QUEUE_FAILED;
+		/* ... and any batch still in flight */
+		if (ft2232_recv_pending() != ERROR_OK)
+			retval = ERROR_JTAG_QUEUE_FAILED;
 
 		/* current command */
 		ft2232_end_state(cmd->cmd.scan->end_state);
@@ -2043,6 +2102,17 @@ static int ft2232_execute_queue(void)
 	if (layout->blink)
 		layout->blink();
 
+	if (ft2232_pipeline && !ft2232_buffers[1])
+	{
+		ft2232_buffers[1] = malloc(FT2232_BUFFER_SIZE);
+		if (!ft2232_buffers[1])
+		{
+			/* one buffer can't hold a batch and a pending read */
+			LOG_ERROR("out of memory for the second buffer, disabling ft2232_pipeline");
+			ft2232_pipeline = false;
+		}
+	}
+
 	while (cmd)
 	{
 		if (ft2232_execute_command(cmd) != ERROR_OK)
@@ -2051,7 +2121,12 @@ static int ft2232_execute_queue(void)
 		cmd = cmd->next;
 		if (ft2232_expect_read > 256)
 		{
-			if (ft2232_send_and_recv(first_unsent, cmd) != ERROR_OK)
+			/* when pipelining, the data is read back once the
+			 * next batch has been built
+			 */
+			if (ft2232_send(first_unsent, cmd) != ERROR_OK)
+				retval = ERROR_JTAG_QUEUE_FAILED;
+			if (!ft2232_pipeline && ft2232_recv_pending() != ERROR_OK)
 				retval = ERROR_JTAG_QUEUE_FAILED;
 			first_unsent = cmd;
 		}
@@ -2061,6 +2136,10 @@ static int ft2232_execute_queue(void)
 		if (ft2232_send_and_recv(first_unsent, cmd) != ERROR_OK)
 			retval = ERROR_JTAG_QUEUE_FAILED;
 
+	/* callers may look at the results once we return */
+	if (ft2232_recv_pending() != ERROR_OK)
+		retval = ERROR_JTAG_QUEUE_FAILED;
+
 	return retval;
 }
 
@@ -2377,6 +2456,7 @@ static int ft2232_init(void)
 
 	ft2232_buffer_size = 0;
 	ft2232_buffer = malloc(FT2232_BUFFER_SIZE);
+	ft2232_buffers[0] = ft2232_buffer;
 
 	if (layout->init() != ERROR_OK)
 		return ERROR_JTAG_INIT_FAILED;
@@ -3270,7 +3350,9 @@ static int ft2232_quit(void)
 	ftdi_deinit(&ftdic);
 #endif
 
-	free(ft2232_buffer);
+	free(ft2232_buffers[0]);
+	free(ft2232_buffers[1]);
+	ft2232_buffers[0] = ft2232_buffers[1] = NULL;
 	ft2232_buffer = NULL;
 
 	return ERROR_OK;
@@ -3397,6 +3479,27 @@ COMMAND_HANDLER(ft2232_handle_latency_command)
 	return ERROR_OK;
 }
 
+COMMAND_HANDLER(ft2232_handle_pipeline_command)
+{
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (CMD_ARGC == 1)
+	{
+		if (strcmp(CMD_ARGV[0], "enable") == 0)
+			ft2232_pipeline = true;
+		else if (strcmp(CMD_ARGV[0], "disable") == 0)
+			ft2232_pipeline = false;
+		else
+			return ERROR_COMMAND_SYNTAX_ERROR;
+	}
+
+	command_print(CMD_CTX, "ft2232 pipelining %s",
+			ft2232_pipeline ? "enabled" : "disabled");
+
+	return ERROR_OK;
+}
+
 static int ft2232_stableclocks(int num_cycles, struct jtag_command* cmd)
 {
 	int retval = 0;
@@ -4497,6 +4600,14 @@ static const struct command_registration ft2232_command_handlers[] = {
 		.help = "set the FT2232 latency timer to a new value",
 		.usage = "value",
 	},
+	{
+		.name = "ft2232_pipeline",
+		.handler = &ft2232_handle_pipeline_command,
+		.mode = COMMAND_ANY,
+		.help = "Display or change whether the next batch of MPSSE "
+			"commands is built while the previous one runs.",
+		.usage = "['enable'|'disable']",
+	},
 	COMMAND_REGISTRATION_DONE
 };
 
@@ -28,6 +28,7 @@
 #include <jtag/interface.h>
 #include <jtag/commands.h>
 #include "usb_common.h"
+#include <helper/perf.h>
 
 /* See Segger's public documentation:
  *	Reference manual for J-Link USB Protocol
@@ -1048,6 +1049,10 @@ static int jlink_usb_write(struct jlink *jlink, int out_length)
 	DEBUG_JTAG_IO("jlink_usb_write, out_length = %d, result = %d",
 			out_length, result);
 
+	perf_count(PERF_ADAPTER_WRITES, 1);
+	if (result > 0)
+		perf_count(PERF_ADAPTER_BYTES_OUT, result);
+
 #ifdef _DEBUG_USB_COMMS_
 	jlink_debug_buffer(usb_out_buffer, out_length);
 #endif
@@ -1062,6 +1067,10 @@ static int jlink_usb_read(struct jlink *jlink, int expected_size)
 
 	DEBUG_JTAG_IO("jlink_usb_read, result = %d", result);
 
+	perf_count(PERF_ADAPTER_READS, 1);
+	if (result > 0)
+		perf_count(PERF_ADAPTER_BYTES_IN, result);
+
 #ifdef _DEBUG_USB_COMMS_
 	jlink_debug_buffer(usb_in_buffer, result);
 #endif
@@ -0,0 +1,423 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "jtag.h"
+#include "interface.h"
+#include "commands.h"
+
+/**
+ * @file
+ * Optional pass over the JTAG command queue, run just before it is
+ * handed to the adapter driver's execute_queue() method.
+ *
+ * It tracks the TAP state and the instruction last loaded into each
+ * TAP as the queue would leave them, and:
+ *  - drops IR scans which reload the instructions already in every TAP,
+ *    when nobody asked for the captured IR bits (a short pathmove
+ *    replaces the scan if its end state differs from the current one);
+ *  - merges back-to-back runtest, pathmove and sleep commands;
+ *  - drops idle runtests and repeated TAP resets.
+ *
+ * Dropping an IR scan skips an Update-IR.  TAPs where re-loading the
+ * same instruction has side effects must not be used with this enabled,
+ * which is why it is off by default.
+ */
+
+/// Longest pathmove produced by merging; some drivers chunk long paths.
+#define OPT_MAX_PATH_STATES	32
+
+struct opt_ir_shadow {
+	struct jtag_tap *tap;
+	uint8_t *value;
+	int num_bits;
+};
+
+static bool opt_enabled;
+static struct jtag_optimize_stats opt_stats;
+
+/// TAP state the already executed queue left the chain in.
+static tap_state_t opt_state = TAP_INVALID;
+
+/// Instructions loaded by the last IR scan, one entry per enabled TAP.
+static struct opt_ir_shadow *opt_shadow;
+static unsigned opt_shadow_count;
+static bool opt_shadow_valid;
+
+static void opt_shadow_invalidate(void)
+{
+	opt_shadow_valid = false;
+}
+
+void jtag_optimize_invalidate(void)
+{
+	opt_shadow_invalidate();
+	opt_state = TAP_INVALID;
+}
+
+static bool opt_bits_equal(const uint8_t *a, const uint8_t *b, int num_bits)
+{
+	int bytes = num_bits / 8;
+	int trailing = num_bits % 8;
+
+	if (memcmp(a, b, bytes) != 0)
+		return false;
+	if (!trailing)
+		return true;
+
+	uint8_t mask = (1 << trailing) - 1;
+	return ((a[bytes] ^ b[bytes]) & mask) == 0;
+}
+
+/**
+ * Check that an IR scan has one field per enabled TAP, each of that
+ * TAP's IR length.  That's how interface_jtag_add_ir_scan() builds
+ * them; plain IR scans usually don't look like this.
+ */
+static bool opt_ir_scan_per_tap(const struct scan_command *scan)
+{
+	struct jtag_tap *tap = jtag_tap_next_enabled(NULL);
+	int i;
+
+	for (i = 0; i < scan->num_fields; i++, tap = jtag_tap_next_enabled(tap))
+	{
+		if (!tap || !scan->fields[i].out_value
+				|| scan->fields[i].num_bits != tap->ir_length)
+			return false;
+	}
+
+	return tap == NULL;
+}
+
+static bool opt_ir_scan_redundant(const struct scan_command *scan)
+{
+	struct jtag_tap *tap = jtag_tap_next_enabled(NULL);
+	int i;
+
+	if (!opt_shadow_valid || (unsigned)scan->num_fields != opt_shadow_count)
+		return false;
+
+	for (i = 0; i < scan->num_fields; i++, tap = jtag_tap_next_enabled(tap))
+	{
+		const struct scan_field *field = scan->fields + i;
+
+		/* someone wants the Capture-IR bits, or is checking them */
+		if (field->in_value)
+			return false;
+		if (opt_shadow[i].tap != tap || opt_shadow[i].num_bits != field->num_bits)
+			return false;
+		if (!opt_bits_equal(opt_shadow[i].value, field->out_value, field->num_bits))
+			return false;
+	}
+
+	return true;
+}
+
+static void opt_ir_shadow_update(const struct scan_command *scan)
+{
+	struct jtag_tap *tap = jtag_tap_next_enabled(NULL);
+	int i;
+
+	if (!opt_ir_scan_per_tap(scan))
+	{
+		opt_shadow_invalidate();
+		return;
+	}
+
+	if ((unsigned)scan->num_fields > opt_shadow_count)
+	{
+		struct opt_ir_shadow *shadow = realloc(opt_shadow,
+				scan->num_fields * sizeof(*opt_shadow));
+		if (!shadow)
+		{
+			opt_shadow_invalidate();
+			return;
+		}
+		memset(shadow + opt_shadow_count, 0,
+				(scan->num_fields - opt_shadow_count) * sizeof(*opt_shadow));
+		opt_shadow = shadow;
+	}
+	opt_shadow_count = scan->num_fields;
+
+	for (i = 0; i < scan->num_fields; i++, tap = jtag_tap_next_enabled(tap))
+	{
+		struct opt_ir_shadow *entry = opt_shadow + i;
+		int num_bits = scan->fields[i].num_bits;
+
+		if (entry->num_bits != num_bits)
+		{
+			free(entry->value);
+			entry->value = malloc(DIV_ROUND_UP(num_bits, 8));
+			entry->num_bits = num_bits;
+		}
+		entry->tap = tap;
+		buf_cpy(scan->fields[i].out_value, entry->value, num_bits);
+	}
+
+	opt_shadow_valid = true;
+}
+
+static int opt_path_len(tap_state_t from, tap_state_t to)
+{
+	if (from == to)
+		return 0;
+	return tap_get_tms_path_len(from, to);
+}
+
+/// Estimated TCK cycles an IR scan costs, starting from @a from.
+static int opt_ir_scan_cycles(const struct scan_command *scan, tap_state_t from)
+{
+	/* move to Shift-IR, shift, Exit1-IR and Pause-IR, then onward */
+	return opt_path_len(from, TAP_IRSHIFT) + jtag_scan_size(scan)
+			+ 1 + opt_path_len(TAP_IRPAUSE, scan->end_state);
+}
+
+static bool opt_can_pathmove(tap_state_t from, tap_state_t to)
+{
+	return tap_is_state_stable(from) && tap_is_state_stable(to)
+			&& from != TAP_DRSHIFT && from != TAP_IRSHIFT
+			&& to != TAP_DRSHIFT && to != TAP_IRSHIFT
+			&& to != TAP_RESET;
+}
+
+/// Turn @a cmd into a pathmove from @a from to @a to, in place.
+static void opt_make_pathmove(struct jtag_command *cmd,
+		tap_state_t from, tap_state_t to)
+{
+	int tms = tap_get_tms_path(from, to);
+	int num_states = tap_get_tms_path_len(from, to);
+	struct pathmove_command *pathmove = cmd_queue_alloc(sizeof(*pathmove));
+	tap_state_t state = from;
+	int i;
+
+	pathmove->num_states = num_states;
+	pathmove->path = cmd_queue_alloc(num_states * sizeof(tap_state_t));
+	for (i = 0; i < num_states; i++)
+	{
+		state = tap_state_transition(state, (tms >> i) & 1);
+		pathmove->path[i] = state;
+	}
+
+	cmd->type = JTAG_PATHMOVE;
+	cmd->cmd.pathmove = pathmove;
+}
+
+/**
+ * Try to fold @a cmd into @a prev, the command queued right before it.
+ * @returns true if @a cmd is no longer needed.
+ */
+static bool opt_merge(struct jtag_command *prev, struct jtag_command *cmd)
+{
+	if (!prev || prev->type != cmd->type)
+		return false;
+
+	switch (cmd->type)
+	{
+	case JTAG_RUNTEST:
+		/* cycles spent in Run-Test/Idle are the same either way */
+		if (prev->cmd.runtest->end_state != TAP_IDLE)
+			return false;
+		prev->cmd.runtest->num_cycles += cmd->cmd.runtest->num_cycles;
+		prev->cmd.runtest->end_state = cmd->cmd.runtest->end_state;
+		opt_state = cmd->cmd.runtest->end_state;
+		opt_stats.runtests_merged++;
+		return true;
+
+	case JTAG_PATHMOVE:
+	{
+		struct pathmove_command *a = prev->cmd.pathmove;
+		struct pathmove_command *b = cmd->cmd.pathmove;
+		int num_states = a->num_states + b->num_states;
+		tap_state_t *path;
+
+		if (num_states > OPT_MAX_PATH_STATES)
+			return false;
+
+		path = cmd_queue_alloc(num_states * sizeof(tap_state_t));
+		memcpy(path, a->path, a->num_states * sizeof(tap_state_t));
+		memcpy(path + a->num_states, b->path, b->num_states * sizeof(tap_state_t));
+		a->path = path;
+		a->num_states = num_states;
+		opt_state = path[num_states - 1];
+		opt_stats.pathmoves_merged++;
+		return true;
+	}
+
+	case JTAG_SLEEP:
+		prev->cmd.sleep->us += cmd->cmd.sleep->us;
+		opt_stats.sleeps_merged++;
+		return true;
+
+	case JTAG_TLR_RESET:
+		/* the TAPs are in Test-Logic-Reset already */
+		opt_stats.resets_dropped++;
+		opt_stats.cycles_saved += 5;
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+/**
+ * Work out what @a cmd does to the IR shadow and TAP state, possibly
+ * rewriting it.
+ * @returns true if @a cmd should be removed from the queue.
+ */
+static bool opt_visit(struct jtag_command *cmd)
+{
+	switch (cmd->type)
+	{
+	case JTAG_SCAN:
+	{
+		struct scan_command *scan = cmd->cmd.scan;
+
+		if (!scan->ir_scan)
+		{
+			opt_state = scan->end_state;
+			return false;
+		}
+
+		if (opt_state != TAP_INVALID && opt_ir_scan_redundant(scan))
+		{
+			int cycles = opt_ir_scan_cycles(scan, opt_state);
+
+			if (opt_state == scan->end_state)
+			{
+				opt_stats.ir_scans_dropped++;
+				opt_stats.cycles_saved += cycles;
+				return true;
+			}
+			if (opt_can_pathmove(opt_state, scan->end_state))
+			{
+				cycles -= tap_get_tms_path_len(opt_state, scan->end_state);
+				opt_make_pathmove(cmd, opt_state, scan->end_state);
+				opt_state = scan->end_state;
+				opt_stats.ir_scans_dropped++;
+				opt_stats.cycles_saved += cycles;
+				return false;
+			}
+		}
+
+		opt_ir_shadow_update(scan);
+		opt_state = scan->end_state;
+		return false;
+	}
+
+	case JTAG_RUNTEST:
+		if (cmd->cmd.runtest->num_cycles == 0
+				&& opt_state == TAP_IDLE
+				&& cmd->cmd.runtest->end_state == TAP_IDLE)
+		{
+			opt_stats.runtests_merged++;
+			return true;
+		}
+		opt_state = cmd->cmd.runtest->end_state;
+		return false;
+
+	case JTAG_PATHMOVE:
+	{
+		struct pathmove_command *pathmove = cmd->cmd.pathmove;
+		if (pathmove->num_states > 0)
+			opt_state = pathmove->path[pathmove->num_states - 1];
+		return false;
+	}
+
+	case JTAG_TLR_RESET:
+		opt_shadow_invalidate();
+		opt_state = TAP_RESET;
+		return false;
+
+	case JTAG_RESET:
+		if (cmd->cmd.reset->trst == 1
+				|| (cmd->cmd.reset->srst == 1
+					&& (jtag_get_reset_config() & RESET_SRST_PULLS_TRST)))
+		{
+			opt_shadow_invalidate();
+			opt_state = TAP_RESET;
+		}
+		return false;
+
+	case JTAG_SLEEP:
+	case JTAG_STABLECLOCKS:
+		return false;
+
+	case JTAG_TMS:
+	default:
+		/* arbitrary TMS sequences: we no longer know where we are */
+		jtag_optimize_invalidate();
+		return false;
+	}
+}
+
+void jtag_optimize_queue(void)
+{
+	struct jtag_command **link = &jtag_command_queue;
+	struct jtag_command *prev = NULL;
+
+	if (!opt_enabled)
+		return;
+
+	opt_stats.flushes++;
+
+	while (*link)
+	{
+		struct jtag_command *cmd = *link;
+
+		opt_stats.commands_in++;
+
+		if (opt_merge(prev, cmd) || opt_visit(cmd))
+		{
+			/* commands live in the queue arena; just unlink */
+			*link = cmd->next;
+			continue;
+		}
+
+		opt_stats.commands_out++;
+		prev = cmd;
+		link = &cmd->next;
+	}
+
+	jtag_queue_set_tail(link);
+}
+
+void jtag_optimize_enable(bool enable)
+{
+	if (enable && !opt_enabled)
+	{
+		/* we don't know what happened while we weren't looking */
+		jtag_optimize_invalidate();
+	}
+	opt_enabled = enable;
+}
+
+bool jtag_optimize_is_enabled(void)
+{
+	return opt_enabled;
+}
+
+void jtag_optimize_get_stats(struct jtag_optimize_stats *stats)
+{
+	*stats = opt_stats;
+}
+
+void jtag_optimize_reset_stats(void)
+{
+	memset(&opt_stats, 0, sizeof(opt_stats));
+}
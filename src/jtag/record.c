@@ -0,0 +1,585 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "jtag.h"
+#include "minidriver.h"
+#include "commands.h"
+#include <helper/fileio.h>
+#include <helper/time_support.h>
+
+/**
+ * @file
+ * Records every JTAG command queue handed to the adapter driver into a
+ * binary trace file, together with the TDO data it produced, and plays
+ * such a trace back through whatever driver is in use.  That gives a
+ * repeatable benchmark of the queue, the optimizer and the driver
+ * without the target (or even the adapter, using the dummy driver).
+ *
+ * The trace is a header followed by records.  Each record is a type
+ * byte and its payload; numbers are 32-bit big-endian, TAP states are
+ * single bytes.  A flush record ends each queue; it holds the result
+ * of the flush and the TDO data of every field which captured any,
+ * in queue order.
+ */
+
+#define JTAG_TRACE_MAGIC	"OOCDJTAG"
+#define JTAG_TRACE_VERSION	1
+
+enum jtag_trace_record {
+	JTAG_TRACE_SCAN = 1,
+	JTAG_TRACE_TLR_RESET = 2,
+	JTAG_TRACE_RUNTEST = 3,
+	JTAG_TRACE_RESET = 4,
+	JTAG_TRACE_PATHMOVE = 6,
+	JTAG_TRACE_SLEEP = 7,
+	JTAG_TRACE_STABLECLOCKS = 8,
+	JTAG_TRACE_TMS = 9,
+	JTAG_TRACE_FLUSH = 0x80,
+};
+
+/* scan field flags */
+#define JTAG_TRACE_FIELD_OUT	0x01
+#define JTAG_TRACE_FIELD_IN		0x02
+
+static bool record_active;
+static struct fileio record_file;
+static int record_error;
+
+/// fields whose TDO data goes into the next flush record
+static struct scan_field **record_in_fields;
+static unsigned record_in_count, record_in_size;
+
+static void record_write(const void *data, size_t size)
+{
+	size_t written;
+
+	if (record_error != ERROR_OK || size == 0)
+		return;
+
+	record_error = fileio_write(&record_file, size, data, &written);
+	if (record_error == ERROR_OK && written != size)
+		record_error = ERROR_FILEIO_OPERATION_FAILED;
+}
+
+static void record_u8(uint8_t value)
+{
+	record_write(&value, 1);
+}
+
+static void record_u32(uint32_t value)
+{
+	uint8_t buf[4];
+
+	h_u32_to_be(buf, value);
+	record_write(buf, sizeof(buf));
+}
+
+static void record_in_field(struct scan_field *field)
+{
+	if (record_in_count == record_in_size)
+	{
+		unsigned size = record_in_size ? 2 * record_in_size : 64;
+		struct scan_field **fields = realloc(record_in_fields,
+				size * sizeof(*fields));
+		if (!fields)
+		{
+			record_error = ERROR_FAIL;
+			return;
+		}
+		record_in_fields = fields;
+		record_in_size = size;
+	}
+	record_in_fields[record_in_count++] = field;
+}
+
+static void record_scan(const struct scan_command *scan)
+{
+	int i;
+
+	record_u8(JTAG_TRACE_SCAN);
+	record_u8(scan->ir_scan);
+	record_u8(scan->end_state);
+	record_u32(scan->num_fields);
+
+	for (i = 0; i < scan->num_fields; i++)
+	{
+		struct scan_field *field = scan->fields + i;
+		uint8_t flags = 0;
+
+		if (field->out_value)
+			flags |= JTAG_TRACE_FIELD_OUT;
+		if (field->in_value)
+			flags |= JTAG_TRACE_FIELD_IN;
+
+		record_u32(field->num_bits);
+		record_u8(flags);
+		if (field->out_value)
+			record_write(field->out_value, DIV_ROUND_UP(field->num_bits, 8));
+		if (field->in_value)
+			record_in_field(field);
+	}
+}
+
+void jtag_record_queue(void)
+{
+	struct jtag_command *cmd;
+	int i;
+
+	if (!record_active)
+		return;
+
+	record_in_count = 0;
+
+	for (cmd = jtag_command_queue; cmd; cmd = cmd->next)
+	{
+		switch (cmd->type)
+		{
+		case JTAG_SCAN:
+			record_scan(cmd->cmd.scan);
+			break;
+		case JTAG_TLR_RESET:
+			record_u8(JTAG_TRACE_TLR_RESET);
+			break;
+		case JTAG_RUNTEST:
+			record_u8(JTAG_TRACE_RUNTEST);
+			record_u32(cmd->cmd.runtest->num_cycles);
+			record_u8(cmd->cmd.runtest->end_state);
+			break;
+		case JTAG_RESET:
+			record_u8(JTAG_TRACE_RESET);
+			record_u8(cmd->cmd.reset->trst);
+			record_u8(cmd->cmd.reset->srst);
+			break;
+		case JTAG_PATHMOVE:
+			record_u8(JTAG_TRACE_PATHMOVE);
+			record_u32(cmd->cmd.pathmove->num_states);
+			for (i = 0; i < cmd->cmd.pathmove->num_states; i++)
+				record_u8(cmd->cmd.pathmove->path[i]);
+			break;
+		case JTAG_SLEEP:
+			record_u8(JTAG_TRACE_SLEEP);
+			record_u32(cmd->cmd.sleep->us);
+			break;
+		case JTAG_STABLECLOCKS:
+			record_u8(JTAG_TRACE_STABLECLOCKS);
+			record_u32(cmd->cmd.stableclocks->num_cycles);
+			break;
+		case JTAG_TMS:
+			record_u8(JTAG_TRACE_TMS);
+			record_u32(cmd->cmd.tms->num_bits);
+			record_write(cmd->cmd.tms->bits,
+					DIV_ROUND_UP(cmd->cmd.tms->num_bits, 8));
+			break;
+		default:
+			LOG_ERROR("BUG: can't record JTAG command type %d", cmd->type);
+			break;
+		}
+	}
+}
+
+void jtag_record_results(int retval)
+{
+	uint32_t tdo_bytes = 0;
+	unsigned i;
+
+	if (!record_active)
+		return;
+
+	for (i = 0; i < record_in_count; i++)
+		tdo_bytes += DIV_ROUND_UP(record_in_fields[i]->num_bits, 8);
+
+	record_u8(JTAG_TRACE_FLUSH);
+	record_u32(retval);
+	record_u32(tdo_bytes);
+	for (i = 0; i < record_in_count; i++)
+		record_write(record_in_fields[i]->in_value,
+				DIV_ROUND_UP(record_in_fields[i]->num_bits, 8));
+
+	record_in_count = 0;
+
+	if (record_error != ERROR_OK)
+	{
+		LOG_ERROR("can't write JTAG trace, recording stopped");
+		jtag_record_stop();
+	}
+}
+
+int jtag_record_start(const char *filename)
+{
+	int retval;
+
+	if (record_active)
+		jtag_record_stop();
+
+	retval = fileio_open(&record_file, filename, FILEIO_WRITE, FILEIO_BINARY);
+	if (retval != ERROR_OK)
+		return retval;
+
+	record_error = ERROR_OK;
+	record_write(JTAG_TRACE_MAGIC, strlen(JTAG_TRACE_MAGIC));
+	record_u32(JTAG_TRACE_VERSION);
+	if (record_error != ERROR_OK)
+	{
+		fileio_close(&record_file);
+		return record_error;
+	}
+
+	record_in_count = 0;
+	record_active = true;
+
+	return ERROR_OK;
+}
+
+void jtag_record_stop(void)
+{
+	if (!record_active)
+		return;
+
+	record_active = false;
+	fileio_close(&record_file);
+}
+
+bool jtag_record_is_active(void)
+{
+	return record_active;
+}
+
+/*
+ * Replay
+ */
+
+struct replay_state {
+	const uint8_t *data;
+	size_t size;
+	size_t pos;
+	bool truncated;
+
+	/// fields queued since the last flush that capture TDO data
+	struct scan_field **in_fields;
+	unsigned in_count, in_size;
+};
+
+static const uint8_t *replay_bytes(struct replay_state *rs, size_t size)
+{
+	const uint8_t *p;
+
+	if (rs->size - rs->pos < size)
+	{
+		rs->truncated = true;
+		rs->pos = rs->size;
+		return NULL;
+	}
+
+	p = rs->data + rs->pos;
+	rs->pos += size;
+	return p;
+}
+
+static uint8_t replay_u8(struct replay_state *rs)
+{
+	const uint8_t *p = replay_bytes(rs, 1);
+	return p ? *p : 0;
+}
+
+static uint32_t replay_u32(struct replay_state *rs)
+{
+	const uint8_t *p = replay_bytes(rs, 4);
+	return p ? be_to_h_u32(p) : 0;
+}
+
+static int replay_scan(struct replay_state *rs, struct jtag_replay_stats *stats)
+{
+	struct jtag_command *cmd = cmd_queue_alloc(sizeof(struct jtag_command));
+	struct scan_command *scan = cmd_queue_alloc(sizeof(struct scan_command));
+	uint32_t i;
+
+	scan->ir_scan = replay_u8(rs);
+	scan->end_state = replay_u8(rs);
+	scan->num_fields = replay_u32(rs);
+	if (rs->truncated || (size_t)scan->num_fields > rs->size)
+		return ERROR_FAIL;
+	scan->fields = cmd_queue_alloc(scan->num_fields * sizeof(struct scan_field));
+
+	for (i = 0; i < (uint32_t)scan->num_fields; i++)
+	{
+		struct scan_field *field = scan->fields + i;
+		uint32_t num_bits = replay_u32(rs);
+		uint8_t flags = replay_u8(rs);
+		size_t num_bytes = DIV_ROUND_UP(num_bits, 8);
+
+		if (rs->truncated || num_bytes > rs->size)
+			return ERROR_FAIL;
+
+		memset(field, 0, sizeof(*field));
+		field->num_bits = num_bits;
+		if (flags & JTAG_TRACE_FIELD_OUT)
+		{
+			const uint8_t *out = replay_bytes(rs, num_bytes);
+			if (!out)
+				return ERROR_FAIL;
+			field->out_value = buf_cpy(out, cmd_queue_alloc(num_bytes), num_bits);
+		}
+		if (flags & JTAG_TRACE_FIELD_IN)
+		{
+			field->in_value = cmd_queue_alloc(num_bytes);
+			if (rs->in_count == rs->in_size)
+			{
+				unsigned size = rs->in_size ? 2 * rs->in_size : 64;
+				struct scan_field **fields = realloc(rs->in_fields,
+						size * sizeof(*fields));
+				if (!fields)
+					return ERROR_FAIL;
+				rs->in_fields = fields;
+				rs->in_size = size;
+			}
+			rs->in_fields[rs->in_count++] = field;
+		}
+
+		stats->bits += num_bits;
+	}
+
+	cmd->type = JTAG_SCAN;
+	cmd->cmd.scan = scan;
+	jtag_queue_command(cmd);
+
+	cmd_queue_cur_state = scan->end_state;
+
+	return ERROR_OK;
+}
+
+static int replay_flush(struct replay_state *rs, struct jtag_replay_stats *stats)
+{
+	struct duration bench;
+	uint32_t recorded_retval = replay_u32(rs);
+	uint32_t tdo_bytes = replay_u32(rs);
+	const uint8_t *tdo = replay_bytes(rs, tdo_bytes);
+	uint32_t offset = 0;
+	unsigned i;
+	int retval;
+
+	if (!tdo)
+		return ERROR_FAIL;
+
+	duration_start(&bench);
+	retval = jtag_execute_queue();
+	duration_measure(&bench);
+
+	stats->seconds += duration_elapsed(&bench);
+	stats->flushes++;
+	if ((retval == ERROR_OK) != ((int)recorded_retval == ERROR_OK))
+		stats->result_mismatches++;
+
+	/* the queue was reset, but its pages are only rewound; the TDO
+	 * data stays put until something new is queued */
+	for (i = 0; i < rs->in_count; i++)
+	{
+		struct scan_field *field = rs->in_fields[i];
+		uint32_t num_bytes = DIV_ROUND_UP(field->num_bits, 8);
+
+		if (offset + num_bytes > tdo_bytes)
+			break;
+		if (field->num_bits % 8)
+		{
+			/* ignore the undefined bits of the last byte */
+			uint8_t mask = (1 << (field->num_bits % 8)) - 1;
+			if (memcmp(field->in_value, tdo + offset, num_bytes - 1) != 0
+					|| ((field->in_value[num_bytes - 1]
+						^ tdo[offset + num_bytes - 1]) & mask) != 0)
+				stats->tdo_mismatches++;
+		}
+		else if (memcmp(field->in_value, tdo + offset, num_bytes) != 0)
+			stats->tdo_mismatches++;
+		offset += num_bytes;
+	}
+	rs->in_count = 0;
+
+	return ERROR_OK;
+}
+
+static int replay_record(struct replay_state *rs, uint8_t type,
+		struct jtag_replay_stats *stats)
+{
+	uint32_t count;
+	uint32_t i;
+
+	switch (type)
+	{
+	case JTAG_TRACE_SCAN:
+		stats->commands++;
+		return replay_scan(rs, stats);
+
+	case JTAG_TRACE_TLR_RESET:
+		stats->commands++;
+		cmd_queue_cur_state = TAP_RESET;
+		return interface_jtag_add_tlr();
+
+	case JTAG_TRACE_RUNTEST:
+	{
+		int num_cycles = replay_u32(rs);
+		tap_state_t end_state = replay_u8(rs);
+
+		stats->commands++;
+		stats->cycles += num_cycles;
+		cmd_queue_cur_state = end_state;
+		return interface_jtag_add_runtest(num_cycles, end_state);
+	}
+
+	case JTAG_TRACE_RESET:
+	{
+		int trst = (int8_t)replay_u8(rs);
+		int srst = (int8_t)replay_u8(rs);
+
+		stats->commands++;
+		return interface_jtag_add_reset(trst, srst);
+	}
+
+	case JTAG_TRACE_PATHMOVE:
+	{
+		tap_state_t *path;
+
+		count = replay_u32(rs);
+		if (rs->truncated || count == 0 || count > rs->size)
+			return ERROR_FAIL;
+		path = malloc(count * sizeof(tap_state_t));
+		for (i = 0; i < count; i++)
+			path[i] = replay_u8(rs);
+
+		stats->commands++;
+		stats->cycles += count;
+		cmd_queue_cur_state = path[count - 1];
+		int retval = interface_jtag_add_pathmove(count, path);
+		free(path);
+		return retval;
+	}
+
+	case JTAG_TRACE_SLEEP:
+		stats->commands++;
+		return interface_jtag_add_sleep(replay_u32(rs));
+
+	case JTAG_TRACE_STABLECLOCKS:
+		count = replay_u32(rs);
+		stats->commands++;
+		stats->cycles += count;
+		return interface_jtag_add_clocks(count);
+
+	case JTAG_TRACE_TMS:
+	{
+		const uint8_t *bits;
+
+		count = replay_u32(rs);
+		bits = replay_bytes(rs, DIV_ROUND_UP(count, 8));
+		if (!bits)
+			return ERROR_FAIL;
+
+		stats->commands++;
+		stats->cycles += count;
+		return interface_add_tms_seq(count, bits, TAP_INVALID);
+	}
+
+	case JTAG_TRACE_FLUSH:
+		return replay_flush(rs, stats);
+
+	default:
+		LOG_ERROR("unknown record type 0x%02x at offset %lu",
+				type, (unsigned long)rs->pos - 1);
+		return ERROR_FAIL;
+	}
+}
+
+int jtag_replay(const char *filename, struct jtag_replay_stats *stats)
+{
+	struct replay_state rs;
+	struct fileio file;
+	uint8_t *data;
+	size_t size_read;
+	int size;
+	int retval;
+
+	memset(stats, 0, sizeof(*stats));
+
+	if (record_active)
+	{
+		LOG_ERROR("can't replay a JTAG trace while recording one");
+		return ERROR_FAIL;
+	}
+
+	retval = fileio_open(&file, filename, FILEIO_READ, FILEIO_BINARY);
+	if (retval != ERROR_OK)
+		return retval;
+
+	retval = fileio_size(&file, &size);
+	if (retval != ERROR_OK)
+	{
+		fileio_close(&file);
+		return retval;
+	}
+
+	/* read it all up front, so file access isn't benchmarked */
+	data = malloc(size);
+	if (!data)
+	{
+		fileio_close(&file);
+		return ERROR_FAIL;
+	}
+	retval = fileio_read(&file, size, data, &size_read);
+	fileio_close(&file);
+	if (retval != ERROR_OK || (int)size_read != size)
+	{
+		free(data);
+		return ERROR_FILEIO_OPERATION_FAILED;
+	}
+
+	memset(&rs, 0, sizeof(rs));
+	rs.data = data;
+	rs.size = size;
+
+	const uint8_t *magic = replay_bytes(&rs, strlen(JTAG_TRACE_MAGIC));
+	uint32_t version = replay_u32(&rs);
+	if (!magic || memcmp(magic, JTAG_TRACE_MAGIC, strlen(JTAG_TRACE_MAGIC)) != 0
+			|| version != JTAG_TRACE_VERSION)
+	{
+		LOG_ERROR("%s is not a JTAG trace this version of OpenOCD understands",
+				filename);
+		free(data);
+		return ERROR_FAIL;
+	}
+
+	/* don't leave stray commands queued ahead of the trace */
+	retval = jtag_execute_queue();
+
+	while (retval == ERROR_OK && rs.pos < rs.size)
+	{
+		retval = replay_record(&rs, replay_u8(&rs), stats);
+		if (rs.truncated)
+		{
+			LOG_ERROR("JTAG trace %s is truncated", filename);
+			retval = ERROR_FAIL;
+		}
+	}
+
+	/* a trace cut short may leave a partial queue; run it */
+	if (jtag_execute_queue() != ERROR_OK && retval == ERROR_OK)
+		retval = ERROR_JTAG_QUEUE_FAILED;
+
+	free(rs.in_fields);
+	free(data);
+
+	return retval;
+}
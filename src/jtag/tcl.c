@@ -33,6 +33,7 @@
 
 #include "jtag.h"
 #include "minidriver.h"
+#include "commands.h"
 #include "interface.h"
 #include "interfaces.h"
 
@@ -847,6 +848,121 @@ COMMAND_HANDLER(handle_jtag_init_command)
 	return jtag_init(CMD_CTX);
 }
 
+#ifndef HAVE_JTAG_MINIDRIVER_H
+COMMAND_HANDLER(handle_jtag_queue_stats_command)
+{
+	struct cmd_queue_stats stats;
+
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (CMD_ARGC == 1)
+	{
+		if (strcmp(CMD_ARGV[0], "reset") != 0)
+			return ERROR_COMMAND_SYNTAX_ERROR;
+		cmd_queue_reset_stats();
+	}
+
+	cmd_queue_get_stats(&stats);
+	command_print(CMD_CTX, "command queue: %u pages (%lu bytes), "
+			"high water mark %lu bytes, %u flushes",
+			stats.pages, (unsigned long)stats.page_bytes,
+			(unsigned long)stats.high_water, stats.resets);
+
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_jtag_optimize_command)
+{
+	struct jtag_optimize_stats stats;
+
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (CMD_ARGC == 1)
+	{
+		bool enable;
+		if (strcmp(CMD_ARGV[0], "enable") == 0)
+			enable = true;
+		else if (strcmp(CMD_ARGV[0], "disable") == 0)
+			enable = false;
+		else
+			return ERROR_COMMAND_SYNTAX_ERROR;
+
+		if (enable && !jtag_optimize_is_enabled())
+			jtag_optimize_reset_stats();
+		jtag_optimize_enable(enable);
+	}
+
+	command_print(CMD_CTX, "queue optimizer %s",
+			jtag_optimize_is_enabled() ? "enabled" : "disabled");
+
+	jtag_optimize_get_stats(&stats);
+	if (stats.flushes == 0)
+		return ERROR_OK;
+
+	command_print(CMD_CTX, "%u flushes, %lu of %lu commands kept",
+			stats.flushes, stats.commands_out, stats.commands_in);
+	command_print(CMD_CTX, "dropped %lu IR scans and %lu TAP resets, "
+			"merged %lu runtests, %lu pathmoves and %lu sleeps",
+			stats.ir_scans_dropped, stats.resets_dropped,
+			stats.runtests_merged, stats.pathmoves_merged,
+			stats.sleeps_merged);
+	command_print(CMD_CTX, "about %llu TCK cycles saved",
+			stats.cycles_saved);
+
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_jtag_record_command)
+{
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (CMD_ARGC == 1)
+	{
+		if (strcmp(CMD_ARGV[0], "stop") == 0)
+			jtag_record_stop();
+		else
+		{
+			int retval = jtag_record_start(CMD_ARGV[0]);
+			if (retval != ERROR_OK)
+				return retval;
+		}
+	}
+
+	command_print(CMD_CTX, "JTAG recording %s",
+			jtag_record_is_active() ? "active" : "stopped");
+
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_jtag_replay_command)
+{
+	struct jtag_replay_stats stats;
+
+	if (CMD_ARGC != 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	int retval = jtag_replay(CMD_ARGV[0], &stats);
+
+	command_print(CMD_CTX, "replayed %lu commands in %lu flushes, "
+			"%llu bits scanned and %llu other TCK cycles",
+			stats.commands, stats.flushes, stats.bits, stats.cycles);
+	if (stats.seconds > 0)
+		command_print(CMD_CTX, "executed in %fs "
+				"(%.0f commands/s, %.0f kbit/s)",
+				stats.seconds, stats.commands / stats.seconds,
+				stats.bits / stats.seconds / 1000);
+	if (stats.result_mismatches || stats.tdo_mismatches)
+		command_print(CMD_CTX, "%lu flush results and %lu TDO fields "
+				"differ from the recording",
+				stats.result_mismatches, stats.tdo_mismatches);
+
+	return retval;
+}
+#endif
+
 static const struct command_registration jtag_subcommand_handlers[] = {
 	{
 		.name = "init",
@@ -928,6 +1044,42 @@ static const struct command_registration jtag_subcommand_handlers[] = {
 		.jim_handler = jim_jtag_names,
 		.help = "Returns list of all JTAG tap names.",
 	},
+#ifndef HAVE_JTAG_MINIDRIVER_H
+	{
+		.name = "optimize",
+		.mode = COMMAND_ANY,
+		.handler = handle_jtag_optimize_command,
+		.help = "Display or change whether the JTAG command queue "
+			"is optimized before it is executed, and show what "
+			"the optimizer saved.",
+		.usage = "['enable'|'disable']",
+	},
+	{
+		.name = "record",
+		.mode = COMMAND_ANY,
+		.handler = handle_jtag_record_command,
+		.help = "Start or stop recording every JTAG command queue "
+			"and its TDO data to a binary trace file.",
+		.usage = "[filename|'stop']",
+	},
+	{
+		.name = "replay",
+		.mode = COMMAND_EXEC,
+		.handler = handle_jtag_replay_command,
+		.help = "Play back a JTAG trace through the current adapter "
+			"and report the throughput and any TDO mismatches.",
+		.usage = "filename",
+	},
+	{
+		.name = "queue_stats",
+		.mode = COMMAND_EXEC,
+		.handler = handle_jtag_queue_stats_command,
+		.help = "Display how much memory the JTAG command queue "
+			"has reserved and the most it has needed so far.  "
+			"With 'reset', restart the high water mark.",
+		.usage = "['reset']",
+	},
+#endif
 	{
 		.chain = jtag_command_handlers_to_move,
 	},
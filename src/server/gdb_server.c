@@ -33,8 +33,8 @@
 #include "server.h"
 #include <flash/nor/core.h>
 #include "gdb_server.h"
-#include <target/image.h>
 #include <jtag/jtag.h>
+#include <helper/perf.h>
 
 
 /**
@@ -54,7 +54,8 @@ struct gdb_connection
 	int buf_cnt;
 	int ctrl_c;
 	enum target_state frontend_state;
-	struct image *vflash_image;
+	/* vFlashWrite data, programmed a sector at a time */
+	struct flash_stream *vflash_stream;
 	int closed;
 	int busy;
 	int noack_mode;
@@ -67,6 +68,12 @@ struct gdb_connection
 	 * (ca. 10% or so...).
 	 */
 	bool mem_write_error;
+	/* outgoing packets are framed here, '$' payload '#' checksum, and
+	 * go out in a single write; replies can be built in place, see
+	 * gdb_reply_buffer() */
+	char *out_buf;
+	int out_size;
+	bool out_reserved;
 };
 
 
@@ -80,6 +87,8 @@ static int gdb_breakpoint_override;
 static enum breakpoint_type gdb_breakpoint_override_type;
 
 static int gdb_error(struct connection *connection, int retval);
+static void gdb_stop_reply(struct connection *connection,
+		struct target *target, int signal_var);
 static const char *gdb_port;
 static const char *gdb_port_next;
 static const char DIGITS[16] = "0123456789abcdef";
@@ -336,11 +345,95 @@ static int gdb_write(struct connection *connection, void *data, int len)
 	return ERROR_SERVER_REMOTE_CLOSED;
 }
 
-static int gdb_put_packet_inner(struct connection *connection,
-		char *buffer, int len)
+/* make room for a packet with a payload of @a len bytes */
+static int gdb_out_reserve(struct gdb_connection *gdb_con, int len)
+{
+	int size = gdb_con->out_size;
+	char *buf;
+
+	if (len + 4 <= size)
+		return ERROR_OK;
+
+	if (size < 1024)
+		size = 1024;
+	while (size < len + 4)
+		size *= 2;
+
+	buf = realloc(gdb_con->out_buf, size);
+	if (buf == NULL)
+		return ERROR_FAIL;
+
+	gdb_con->out_buf = buf;
+	gdb_con->out_size = size;
+	return ERROR_OK;
+}
+
+/**
+ * Return space for a reply payload of up to @a len bytes in the
+ * connection's output buffer.  When it's filled in and passed to
+ * gdb_put_packet(), the packet is framed and sent without a copy.
+ * Returns NULL if there isn't the memory.
+ */
+static char *gdb_reply_buffer(struct connection *connection, int len)
+{
+	struct gdb_connection *gdb_con = connection->priv;
+
+	if (gdb_con->out_reserved || (gdb_out_reserve(gdb_con, len) != ERROR_OK))
+		return NULL;
+
+	gdb_con->out_reserved = true;
+	return gdb_con->out_buf + 1;
+}
+
+/**
+ * Frame a packet with a payload of @a len bytes: in place if it was
+ * built in gdb_reply_buffer(), else copied to the output buffer or, if
+ * a reply is being built there, to @a local_frame which the caller must
+ * free().
+ */
+static char *gdb_frame_packet(struct gdb_connection *gdb_con,
+		char *buffer, int len, char **local_frame)
 {
-	int i;
 	unsigned char my_checksum = 0;
+	char *frame;
+	int i;
+
+	*local_frame = NULL;
+
+	if (gdb_con->out_reserved && (buffer == gdb_con->out_buf + 1))
+	{
+		frame = gdb_con->out_buf;
+		gdb_con->out_reserved = false;
+	}
+	else
+	{
+		if (!gdb_con->out_reserved && (gdb_out_reserve(gdb_con, len) == ERROR_OK))
+			frame = gdb_con->out_buf;
+		else
+		{
+			/* e.g. console output while a reply is being built */
+			frame = *local_frame = malloc(len + 4);
+			if (frame == NULL)
+				return NULL;
+		}
+		memcpy(frame + 1, buffer, len);
+	}
+
+	for (i = 1; i <= len; i++)
+		my_checksum += frame[i];
+
+	frame[0] = '$';
+	frame[len + 1] = '#';
+	frame[len + 2] = DIGITS[(my_checksum >> 4) & 0xf];
+	frame[len + 3] = DIGITS[my_checksum & 0xf];
+
+	return frame;
+}
+
+/* send a framed packet, with a payload of @a len bytes */
+static int gdb_put_packet_inner(struct connection *connection,
+		char *frame, int len)
+{
 #ifdef _DEBUG_GDB_IO_
 	char *debug_buffer;
 #endif
@@ -348,9 +441,6 @@ static int gdb_put_packet_inner(struct connection *connection,
 	int retval;
 	struct gdb_connection *gdb_con = connection->priv;
 
-	for (i = 0; i < len; i++)
-		my_checksum += buffer[i];
-
 #ifdef _DEBUG_GDB_IO_
 	/*
 	 * At this point we should have nothing in the input queue from GDB,
@@ -381,47 +471,15 @@ static int gdb_put_packet_inner(struct connection *connection,
 	while (1)
 	{
 #ifdef _DEBUG_GDB_IO_
-		debug_buffer = malloc(len + 1);
-		memcpy(debug_buffer, buffer, len);
-		debug_buffer[len] = 0;
-		LOG_DEBUG("sending packet '$%s#%2.2x'", debug_buffer, my_checksum);
+		debug_buffer = malloc(len + 5);
+		memcpy(debug_buffer, frame, len + 4);
+		debug_buffer[len + 4] = 0;
+		LOG_DEBUG("sending packet '%s'", debug_buffer);
 		free(debug_buffer);
 #endif
 
-		char local_buffer[1024];
-		local_buffer[0] = '$';
-		if ((size_t)len + 4 <= sizeof(local_buffer))
-		{
-			/* performance gain on smaller packets by only a single call to gdb_write() */
-			memcpy(local_buffer + 1, buffer, len++);
-			local_buffer[len++] = '#';
-			local_buffer[len++] = DIGITS[(my_checksum >> 4) & 0xf];
-			local_buffer[len++] = DIGITS[my_checksum & 0xf];
-			if ((retval = gdb_write(connection, local_buffer, len)) != ERROR_OK)
-			{
-				return retval;
-			}
-		}
-		else
-		{
-			/* larger packets are transmitted directly from caller supplied buffer
-			   by several calls to gdb_write() to avoid dynamic allocation */
-			local_buffer[1] = '#';
-			local_buffer[2] = DIGITS[(my_checksum >> 4) & 0xf];
-			local_buffer[3] = DIGITS[my_checksum & 0xf];
-			if ((retval = gdb_write(connection, local_buffer, 1)) != ERROR_OK)
-			{
-				return retval;
-			}
-			if ((retval = gdb_write(connection, buffer, len)) != ERROR_OK)
-			{
-				return retval;
-			}
-			if ((retval = gdb_write(connection, local_buffer + 1, 3)) != ERROR_OK)
-			{
-				return retval;
-			}
-		}
+		if ((retval = gdb_write(connection, frame, len + 4)) != ERROR_OK)
+			return retval;
 
 		if (gdb_con->noack_mode)
 			break;
@@ -482,10 +540,18 @@ static int gdb_put_packet_inner(struct connection *connection,
 static int gdb_put_packet(struct connection *connection, char *buffer, int len)
 {
 	struct gdb_connection *gdb_con = connection->priv;
+	char *frame, *local_frame;
+
+	frame = gdb_frame_packet(gdb_con, buffer, len, &local_frame);
+	if (frame == NULL)
+		return ERROR_FAIL;
+
 	gdb_con->busy = 1;
-	int retval = gdb_put_packet_inner(connection, buffer, len);
+	int retval = gdb_put_packet_inner(connection, frame, len);
 	gdb_con->busy = 0;
 
+	free(local_frame);
+
 	/* we sent some data, reset timer for keep alive messages */
 	kept_alive();
 
@@ -748,7 +814,6 @@ static void gdb_frontend_halted(struct target *target, struct connection *connec
 	 */
 	if (gdb_connection->frontend_state == TARGET_RUNNING)
 	{
-		char sig_reply[4];
 		int signal_var;
 
 		/* stop forwarding log packets! */
@@ -764,8 +829,7 @@ static void gdb_frontend_halted(struct target *target, struct connection *connec
 			signal_var = gdb_last_signal(target);
 		}
 
-		snprintf(sig_reply, 4, "T%2.2x", signal_var);
-		gdb_put_packet(connection, sig_reply, 3);
+		gdb_stop_reply(connection, target, signal_var);
 		gdb_connection->frontend_state = TARGET_HALTED;
 	}
 }
@@ -813,12 +877,15 @@ static int gdb_new_connection(struct connection *connection)
 	gdb_connection->buf_cnt = 0;
 	gdb_connection->ctrl_c = 0;
 	gdb_connection->frontend_state = TARGET_HALTED;
-	gdb_connection->vflash_image = NULL;
+	gdb_connection->vflash_stream = NULL;
 	gdb_connection->closed = 0;
 	gdb_connection->busy = 0;
 	gdb_connection->noack_mode = 0;
 	gdb_connection->sync = true;
 	gdb_connection->mem_write_error = false;
+	gdb_connection->out_buf = NULL;
+	gdb_connection->out_size = 0;
+	gdb_connection->out_reserved = false;
 
 	/* send ACK to GDB for debug request */
 	gdb_write(connection, "+", 1);
@@ -896,12 +963,14 @@ static int gdb_connection_closed(struct connection *connection)
 		  target_state_name(gdb_service->target),
 		  gdb_actual_connections);
 
-	/* see if an image built with vFlash commands is left */
-	if (gdb_connection->vflash_image)
+	/* see if an unfinished vFlashWrite stream is left; its write
+	 * start event has fired, so pair it */
+	if (gdb_connection->vflash_stream)
 	{
-		image_close(gdb_connection->vflash_image);
-		free(gdb_connection->vflash_image);
-		gdb_connection->vflash_image = NULL;
+		flash_stream_close(gdb_connection->vflash_stream, NULL);
+		gdb_connection->vflash_stream = NULL;
+		target_call_event_callbacks(gdb_service->target,
+				TARGET_EVENT_GDB_FLASH_WRITE_END);
 	}
 
 	/* if this connection registered a debug-message receiver delete it */
@@ -909,6 +978,7 @@ static int gdb_connection_closed(struct connection *connection)
 
 	if (connection->priv)
 	{
+		free(gdb_connection->out_buf);
 		free(connection->priv);
 		connection->priv = NULL;
 	}
@@ -937,13 +1007,7 @@ static void gdb_send_error(struct connection *connection, uint8_t the_error)
 static int gdb_last_signal_packet(struct connection *connection,
 		struct target *target, char* packet, int packet_size)
 {
-	char sig_reply[4];
-	int signal_var;
-
-	signal_var = gdb_last_signal(target);
-
-	snprintf(sig_reply, 4, "S%2.2x", signal_var);
-	gdb_put_packet(connection, sig_reply, 3);
+	gdb_stop_reply(connection, target, gdb_last_signal(target));
 
 	return ERROR_OK;
 }
@@ -983,6 +1047,76 @@ static void gdb_str_to_target(struct target *target,
 	}
 }
 
+/* Registers GDB needs at every stop to find the frame: pc, stack
+ * pointer, link register, the ARM and Thumb frame pointers (r11, r7)
+ * and the status register.  Banked ARM registers match too, e.g.
+ * "sp_svc" or "r11_fiq".
+ */
+static bool gdb_reg_expedited(const char *name)
+{
+	static const char *const expedited[] = {
+		"pc", "sp", "lr", "r7", "r11", "cpsr", "xPSR",
+	};
+	size_t len = strcspn(name, "_");
+	unsigned i;
+
+	for (i = 0; i < ARRAY_SIZE(expedited); i++)
+	{
+		if (strlen(expedited[i]) == len
+				&& strncmp(name, expedited[i], len) == 0)
+			return true;
+	}
+	return false;
+}
+
+/* Fetch a register from the target if the debug entry code didn't */
+static int gdb_fetch_reg(struct reg *reg)
+{
+	if (reg->valid || !reg->type || !reg->type->get)
+		return ERROR_OK;
+	return reg->type->get(reg);
+}
+
+/* Send a "T" stop reply carrying the frame registers which the debug
+ * entry code already read, so GDB needn't ask for them with a 'g'
+ * packet.  Registers which aren't cached are left for 'p'/'g'.
+ */
+static void gdb_stop_reply(struct connection *connection,
+		struct target *target, int signal_var)
+{
+	char reply[256];
+	int len;
+	struct reg **reg_list;
+	int reg_list_size;
+	int i;
+
+	len = snprintf(reply, sizeof(reply), "T%2.2x", signal_var & 0xff);
+
+	if (target->state == TARGET_HALTED
+			&& target_get_gdb_reg_list(target, &reg_list,
+					&reg_list_size) == ERROR_OK)
+	{
+		for (i = 0; i < reg_list_size; i++)
+		{
+			struct reg *reg = reg_list[i];
+			int chars = DIV_ROUND_UP(reg->size, 8) * 2;
+
+			if (!reg->valid || !gdb_reg_expedited(reg->name))
+				continue;
+			if (len + chars + 4 > (int)sizeof(reply))
+				break;
+
+			len += snprintf(reply + len, sizeof(reply) - len, "%x:", i);
+			gdb_str_to_target(target, reply + len, reg);
+			len += chars;
+			reply[len++] = ';';
+		}
+		free(reg_list);
+	}
+
+	gdb_put_packet(connection, reply, len);
+}
+
 static int hextoint(int c)
 {
 	if (c>='0'&&c<='9')
@@ -1041,10 +1175,21 @@ static int gdb_get_registers_packet(struct connection *connection,
 
 	for (i = 0; i < reg_list_size; i++)
 	{
+		retval = gdb_fetch_reg(reg_list[i]);
+		if (retval != ERROR_OK)
+		{
+			free(reg_list);
+			return gdb_error(connection, retval);
+		}
 		reg_packet_size += reg_list[i]->size;
 	}
 
-	reg_packet = malloc(DIV_ROUND_UP(reg_packet_size, 8) * 2);
+	reg_packet = gdb_reply_buffer(connection, DIV_ROUND_UP(reg_packet_size, 8) * 2);
+	if (reg_packet == NULL)
+	{
+		free(reg_list);
+		return gdb_error(connection, ERROR_FAIL);
+	}
 	reg_packet_p = reg_packet;
 
 	for (i = 0; i < reg_list_size; i++)
@@ -1063,7 +1208,6 @@ static int gdb_get_registers_packet(struct connection *connection,
 #endif
 
 	gdb_put_packet(connection, reg_packet, DIV_ROUND_UP(reg_packet_size, 8) * 2);
-	free(reg_packet);
 
 	free(reg_list);
 
@@ -1137,6 +1281,7 @@ static int gdb_get_register_packet(struct connection *connection,
 	struct reg **reg_list;
 	int reg_list_size;
 	int retval;
+	int len;
 
 #ifdef _DEBUG_GDB_IO_
 	LOG_DEBUG("-");
@@ -1153,14 +1298,26 @@ static int gdb_get_register_packet(struct connection *connection,
 		exit(-1);
 	}
 
-	reg_packet = malloc(DIV_ROUND_UP(reg_list[reg_num]->size, 8) * 2);
+	retval = gdb_fetch_reg(reg_list[reg_num]);
+	if (retval != ERROR_OK)
+	{
+		free(reg_list);
+		return gdb_error(connection, retval);
+	}
+
+	len = DIV_ROUND_UP(reg_list[reg_num]->size, 8) * 2;
+	reg_packet = gdb_reply_buffer(connection, len);
+	if (reg_packet == NULL)
+	{
+		free(reg_list);
+		return gdb_error(connection, ERROR_FAIL);
+	}
 
 	gdb_str_to_target(target, reg_packet, reg_list[reg_num]);
 
-	gdb_put_packet(connection, reg_packet, DIV_ROUND_UP(reg_list[reg_num]->size, 8) * 2);
+	gdb_put_packet(connection, reg_packet, len);
 
 	free(reg_list);
-	free(reg_packet);
 
 	return ERROR_OK;
 }
@@ -1223,10 +1380,35 @@ static int gdb_error(struct connection *connection, int retval)
 	return ERROR_OK;
 }
 
+/* Escape binary data for a reply, as with the 'X' packet but also
+ * escaping '*', which would otherwise start a run length encoding. */
+static int gdb_escape_binary(char *out, const uint8_t *data, uint32_t len)
+{
+	char *start = out;
+	uint32_t i;
+
+	for (i = 0; i < len; i++)
+	{
+		uint8_t t = data[i];
+
+		if ((t == '#') || (t == '$') || (t == '}') || (t == '*'))
+		{
+			*out++ = '}';
+			t ^= 0x20;
+		}
+		*out++ = t;
+	}
+
+	return out - start;
+}
+
 /* We don't have to worry about the default 2 second timeout for GDB packets,
  * because GDB breaks up large memory reads into smaller reads.
  *
  * 8191 bytes by the looks of it. Why 8191 bytes instead of 8192?????
+ *
+ * 'm' reads memory as hex; 'x' (GDB's "binary-upload") reads it as
+ * escaped binary, which is usually just over half the size.
  */
 static int gdb_read_memory_packet(struct connection *connection,
 		struct target *target, char *packet, int packet_size)
@@ -1234,9 +1416,10 @@ static int gdb_read_memory_packet(struct connection *connection,
 	char *separator;
 	uint32_t addr = 0;
 	uint32_t len = 0;
+	bool binary = (packet[0] == 'x');
 
 	uint8_t *buffer;
-	char *hex_buffer;
+	char *reply;
 
 	int retval = ERROR_OK;
 
@@ -1277,21 +1460,28 @@ static int gdb_read_memory_packet(struct connection *connection,
 		retval = ERROR_OK;
 	}
 
-	if (retval == ERROR_OK)
-	{
-		hex_buffer = malloc(len * 2 + 1);
+	/* at worst every byte is escaped, for binary */
+	if ((retval == ERROR_OK)
+			&& ((reply = gdb_reply_buffer(connection, len * 2 + 1)) == NULL))
+		retval = ERROR_FAIL;
 
+	if ((retval == ERROR_OK) && binary)
+	{
+		reply[0] = 'b';
+		gdb_put_packet(connection, reply,
+				1 + gdb_escape_binary(reply + 1, buffer, len));
+	}
+	else if (retval == ERROR_OK)
+	{
 		uint32_t i;
 		for (i = 0; i < len; i++)
 		{
 			uint8_t t = buffer[i];
-			hex_buffer[2 * i] = DIGITS[(t >> 4) & 0xf];
-			hex_buffer[2 * i + 1] = DIGITS[t & 0xf];
+			reply[2 * i] = DIGITS[(t >> 4) & 0xf];
+			reply[2 * i + 1] = DIGITS[t & 0xf];
 		}
 
-		gdb_put_packet(connection, hex_buffer, len * 2);
-
-		free(hex_buffer);
+		gdb_put_packet(connection, reply, len * 2);
 	}
 	else
 	{
@@ -1876,7 +2066,8 @@ static int gdb_query_packet(struct connection *connection,
 	}
 	else if (strstr(packet, "qSupported"))
 	{
-		/* we currently support packet size and qXfer:memory-map:read (if enabled)
+		/* we currently support packet size, binary memory reads and
+		 * qXfer:memory-map:read (if enabled)
 		 * disable qXfer:features:read for the moment */
 		int retval = ERROR_OK;
 		char *buffer = NULL;
@@ -1884,7 +2075,7 @@ static int gdb_query_packet(struct connection *connection,
 		int size = 0;
 
 		xml_printf(&retval, &buffer, &pos, &size,
-				"PacketSize=%x;qXfer:memory-map:read%c;qXfer:features:read-;QStartNoAckMode+",
+				"PacketSize=%x;qXfer:memory-map:read%c;qXfer:features:read-;QStartNoAckMode+;binary-upload+",
 				(GDB_BUFFER_SIZE - 1), ((gdb_use_memory_map == 1) && (flash_get_bank_count() > 0)) ? '+' : '-');
 
 		if (retval != ERROR_OK)
@@ -2049,21 +2240,36 @@ static int gdb_v_packet(struct connection *connection,
 		}
 		length = packet_size - (parse - packet);
 
-		/* create a new image if there isn't already one */
-		if (gdb_connection->vflash_image == NULL)
+		/* start programming with the first write */
+		if (gdb_connection->vflash_stream == NULL)
 		{
-			gdb_connection->vflash_image = malloc(sizeof(struct image));
-			image_open(gdb_connection->vflash_image, "", "build");
+			gdb_connection->vflash_stream = flash_stream_open(gdb_service->target);
+			if (gdb_connection->vflash_stream == NULL)
+				return ERROR_FAIL;
+			target_call_event_callbacks(gdb_service->target,
+					TARGET_EVENT_GDB_FLASH_WRITE_START);
 		}
 
-		/* create new section with content from packet buffer */
-		if ((retval = image_add_section(gdb_connection->vflash_image, addr, length, 0x0, (uint8_t*)parse)) != ERROR_OK)
+		retval = flash_stream_add(gdb_connection->vflash_stream,
+				addr, (uint8_t *)parse, length);
+		if (retval != ERROR_OK)
 		{
-			return retval;
+			flash_stream_close(gdb_connection->vflash_stream, NULL);
+			gdb_connection->vflash_stream = NULL;
+			target_call_event_callbacks(gdb_service->target,
+					TARGET_EVENT_GDB_FLASH_WRITE_END);
+			gdb_send_error(connection, EIO);
+			return ERROR_OK;
 		}
 
+		/* Reply first, then program the sectors which are complete:
+		 * GDB sends the next packet while the flash is busy.  Errors
+		 * are reported by vFlashDone.
+		 */
 		gdb_put_packet(connection, "OK", 2);
 
+		flash_stream_program(gdb_connection->vflash_stream, false);
+
 		return ERROR_OK;
 	}
 
@@ -2071,10 +2277,20 @@ static int gdb_v_packet(struct connection *connection,
 	{
 		uint32_t written;
 
-		/* process the flashing buffer. No need to erase as GDB
-		 * always issues a vFlashErase first. */
-		target_call_event_callbacks(gdb_service->target, TARGET_EVENT_GDB_FLASH_WRITE_START);
-		result = flash_write(gdb_service->target, gdb_connection->vflash_image, &written, 0);
+		/* program what's left of the vFlashWrite data. No need to
+		 * erase as GDB always issues a vFlashErase first. */
+		if (gdb_connection->vflash_stream == NULL)
+		{
+			target_call_event_callbacks(gdb_service->target, TARGET_EVENT_GDB_FLASH_WRITE_START);
+			result = ERROR_OK;
+			written = 0;
+		}
+		else
+		{
+			result = flash_stream_program(gdb_connection->vflash_stream, true);
+			flash_stream_close(gdb_connection->vflash_stream, &written);
+			gdb_connection->vflash_stream = NULL;
+		}
 		target_call_event_callbacks(gdb_service->target, TARGET_EVENT_GDB_FLASH_WRITE_END);
 		if (result != ERROR_OK)
 		{
@@ -2085,14 +2301,10 @@ static int gdb_v_packet(struct connection *connection,
 			}
 		else
 		{
-			LOG_DEBUG("wrote %u bytes from vFlash image to flash", (unsigned)written);
+			LOG_DEBUG("wrote %u bytes from vFlash stream to flash", (unsigned)written);
 			gdb_put_packet(connection, "OK", 2);
 		}
 
-		image_close(gdb_connection->vflash_image);
-		free(gdb_connection->vflash_image);
-		gdb_connection->vflash_image = NULL;
-
 		return ERROR_OK;
 	}
 
@@ -2133,6 +2345,53 @@ static void gdb_sig_halted(struct connection *connection)
 
 }
 
+static void gdb_count_packet(const char *packet)
+{
+	enum perf_counter counter;
+
+	switch (packet[0])
+	{
+		case 'g':
+		case 'G':
+		case 'p':
+		case 'P':
+			counter = PERF_GDB_PACKETS_REGS;
+			break;
+		case 'm':
+		case 'x':
+			counter = PERF_GDB_PACKETS_MEM_READ;
+			break;
+		case 'M':
+		case 'X':
+			counter = PERF_GDB_PACKETS_MEM_WRITE;
+			break;
+		case 'c':
+		case 's':
+			counter = PERF_GDB_PACKETS_RUN;
+			break;
+		case 'z':
+		case 'Z':
+			counter = PERF_GDB_PACKETS_BREAK;
+			break;
+		case 'q':
+		case 'Q':
+			counter = PERF_GDB_PACKETS_QUERY;
+			break;
+		case 'v':
+			if (strncmp(packet, "vFlash", 6) == 0)
+				counter = PERF_GDB_PACKETS_FLASH;
+			else if (strncmp(packet, "vCont", 5) == 0)
+				counter = PERF_GDB_PACKETS_RUN;
+			else
+				counter = PERF_GDB_PACKETS_OTHER;
+			break;
+		default:
+			counter = PERF_GDB_PACKETS_OTHER;
+			break;
+	}
+	perf_count(counter, 1);
+}
+
 static int gdb_input_inner(struct connection *connection)
 {
 	/* Do not allocate this on the stack */
@@ -2167,6 +2426,9 @@ static int gdb_input_inner(struct connection *connection)
 		/* terminate with zero */
 		packet[packet_size] = 0;
 
+		/* drop any reply buffer left reserved by an error path */
+		gdb_con->out_reserved = false;
+
 		if (LOG_LEVEL_IS(LOG_LVL_DEBUG)) {
 			if (packet[0] == 'X') {
 				// binary packets spew junk into the debug log stream
@@ -2184,6 +2446,8 @@ static int gdb_input_inner(struct connection *connection)
 
 		if (packet_size > 0)
 		{
+			gdb_count_packet(packet);
+
 			retval = ERROR_OK;
 			switch (packet[0])
 			{
@@ -2219,6 +2483,7 @@ static int gdb_input_inner(struct connection *connection)
 							packet, packet_size);
 					break;
 				case 'm':
+				case 'x':
 					retval = gdb_read_memory_packet(
 							connection, target,
 							packet, packet_size);
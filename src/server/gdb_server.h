@@ -29,7 +29,9 @@
 struct image;
 #include <target/target.h>
 
-#define GDB_BUFFER_SIZE	16384
+/* also the PacketSize given to GDB, so it bounds memory reads and
+ * writes, and flash downloads, per packet */
+#define GDB_BUFFER_SIZE	65536
 
 struct gdb_service
 {
@@ -32,6 +32,7 @@
 #include "openocd.h"
 #include "tcl_server.h"
 #include "telnet_server.h"
+#include <helper/perf.h>
 
 #include <signal.h>
 
@@ -432,6 +433,7 @@ int server_loop(struct command_context *command_context)
 			/* We only execute these callbacks when there was nothing to do or we timed out */
 			target_call_timer_callbacks();
 			process_jim_events(command_context);
+			perf_poll();
 
 			FD_ZERO(&read_fds); /* eCos leaves read_fds unchanged in this case!  */
 
@@ -75,11 +75,7 @@
  * @param invalue NULL, or points to a 32-bit (little-endian) integer
  * @param ack points to where the three bit JTAG_ACK_* code will be stored
  */
-
-/* FIXME don't export ... this is a temporary workaround for the
- * mem_ap_read_buf_u32() mess, until it's no longer JTAG-specific.
- */
-int adi_jtag_dp_scan(struct adiv5_dap *dap,
+static int adi_jtag_dp_scan(struct adiv5_dap *dap,
 		uint8_t instr, uint8_t reg_addr, uint8_t RnW,
 		uint8_t *outvalue, uint8_t *invalue, uint8_t *ack)
 {
@@ -409,6 +405,39 @@ static int jtag_ap_q_read(struct adiv5_dap *dap, unsigned reg,
 			DPAP_READ, 0, data);
 }
 
+static int jtag_ap_q_read_block(struct adiv5_dap *dap, unsigned reg,
+		uint32_t count, uint8_t *buffer)
+{
+	uint32_t i;
+	int retval = jtag_ap_q_bankselect(dap, reg);
+
+	if (retval != ERROR_OK)
+		return retval;
+
+	/* Scan out first read */
+	retval = adi_jtag_dp_scan(dap, JTAG_DP_APACC, reg,
+			DPAP_READ, 0, NULL, NULL);
+	if (retval != ERROR_OK)
+		return retval;
+	for (i = 0; i < count - 1; i++)
+	{
+		/* Scan out next read; scan in posted value for the
+		 * previous one.  Assumes read is acked "OK/FAULT",
+		 * and CTRL_STAT says that meant "OK".
+		 */
+		retval = adi_jtag_dp_scan(dap, JTAG_DP_APACC, reg,
+				DPAP_READ, 0, buffer + 4 * i, &dap->ack);
+		if (retval != ERROR_OK)
+			return retval;
+	}
+
+	/* Scan in last posted value; RDBUFF has no other effect,
+	 * assuming ack is OK/FAULT and CTRL_STAT says "OK".
+	 */
+	return adi_jtag_dp_scan(dap, JTAG_DP_DPACC, DP_RDBUFF,
+			DPAP_READ, 0, buffer + 4 * i, &dap->ack);
+}
+
 static int jtag_ap_q_write(struct adiv5_dap *dap, unsigned reg,
 		uint32_t data)
 {
@@ -443,6 +472,7 @@ const struct dap_ops jtag_dp_ops = {
 	.queue_dp_read =	jtag_dp_q_read,
 	.queue_dp_write =	jtag_dp_q_write,
 	.queue_ap_read =	jtag_ap_q_read,
+	.queue_ap_read_block =	jtag_ap_q_read_block,
 	.queue_ap_write =	jtag_ap_q_write,
 	.queue_ap_abort =	jtag_ap_q_abort,
 	.run =			jtag_dp_run,
@@ -22,7 +22,10 @@
 #endif
 
 #include "algorithm.h"
+#include "target.h"
 #include <helper/binarybuffer.h>
+#include <helper/log.h>
+#include <helper/time_support.h>
 
 
 void init_mem_param(struct mem_param *param, uint32_t address, uint32_t size, enum param_direction direction)
@@ -52,3 +55,139 @@ void destroy_reg_param(struct reg_param *param)
 	free(param->value);
 	param->value = NULL;
 }
+
+/**
+ * Streams @a count blocks of @a block_size bytes from @a buffer to an
+ * algorithm which keeps running, through a FIFO in target memory.
+ *
+ * The FIFO occupies @a fifo_size bytes at @a fifo_start:
+ *  - word 0: write pointer, advanced by the host;
+ *  - word 1: read pointer, advanced by the algorithm as it consumes
+ *    data.  The algorithm sets it to zero to report an error and stop,
+ *    and it stops on its own if the host sets the write pointer to zero;
+ *  - the rest: data, a whole number of blocks.
+ * The FIFO is empty when both pointers are equal; the host always leaves
+ * one block unused, so that it is never full with equal pointers.  Both
+ * pointers are absolute addresses, and wrap back to @a fifo_start + 8 at
+ * the end.
+ *
+ * The caller sets up @a reg_params to tell the algorithm where the FIFO
+ * is and how many blocks to expect, then collects its results from them.
+ * This needs a target whose memory can be accessed while it runs.
+ */
+int target_run_fifo_algorithm(struct target *target,
+		uint8_t *buffer, uint32_t count, uint32_t block_size,
+		int num_mem_params, struct mem_param *mem_params,
+		int num_reg_params, struct reg_param *reg_params,
+		uint32_t fifo_start, uint32_t fifo_size,
+		uint32_t entry_point, uint32_t exit_point,
+		int timeout_ms, void *arch_info)
+{
+	uint32_t wp_addr = fifo_start;
+	uint32_t rp_addr = fifo_start + 4;
+	uint32_t data_start = fifo_start + 8;
+	uint32_t fifo_end = fifo_start + fifo_size;
+	uint32_t wp = data_start;
+	int64_t deadline;
+	int retval, retval2;
+
+	/* the data area must hold two blocks or more, and no fractions */
+	if (fifo_size < 8 + 2 * block_size
+			|| (fifo_size - 8) % block_size)
+	{
+		LOG_ERROR("BUG: FIFO of %u bytes doesn't suit %u byte blocks",
+				(unsigned) fifo_size, (unsigned) block_size);
+		return ERROR_INVALID_ARGUMENTS;
+	}
+
+	retval = target_write_u32(target, wp_addr, wp);
+	if (retval != ERROR_OK)
+		return retval;
+	retval = target_write_u32(target, rp_addr, wp);
+	if (retval != ERROR_OK)
+		return retval;
+
+	retval = target_start_algorithm(target,
+			num_mem_params, mem_params,
+			num_reg_params, reg_params,
+			entry_point, exit_point, arch_info);
+	if (retval != ERROR_OK)
+		return retval;
+
+	deadline = timeval_ms() + timeout_ms;
+	while (count > 0)
+	{
+		uint32_t rp, thisrun_bytes;
+
+		retval = target_read_u32(target, rp_addr, &rp);
+		if (retval != ERROR_OK)
+			break;
+
+		if (rp == 0)
+		{
+			LOG_ERROR("algorithm reported an error");
+			retval = ERROR_FAIL;
+			break;
+		}
+		if (rp < data_start || rp >= fifo_end)
+		{
+			LOG_ERROR("corrupted FIFO read pointer 0x%" PRIx32, rp);
+			retval = ERROR_FAIL;
+			break;
+		}
+
+		/* how much fits without catching up with the reader */
+		if (rp > wp)
+			thisrun_bytes = rp - wp - block_size;
+		else
+		{
+			thisrun_bytes = fifo_end - wp;
+			if (rp == data_start)
+				thisrun_bytes -= block_size;
+		}
+		if (thisrun_bytes > count * block_size)
+			thisrun_bytes = count * block_size;
+
+		if (thisrun_bytes == 0)
+		{
+			/* the algorithm is busy with what it has */
+			if (timeval_ms() > deadline)
+			{
+				LOG_ERROR("timeout waiting for the algorithm to "
+						"consume data");
+				retval = ERROR_TARGET_TIMEOUT;
+				break;
+			}
+			keep_alive();
+			continue;
+		}
+
+		retval = target_write_buffer(target, wp, thisrun_bytes, buffer);
+		if (retval != ERROR_OK)
+			break;
+
+		buffer += thisrun_bytes;
+		count -= thisrun_bytes / block_size;
+		wp += thisrun_bytes;
+		if (wp >= fifo_end)
+			wp = data_start;
+
+		retval = target_write_u32(target, wp_addr, wp);
+		if (retval != ERROR_OK)
+			break;
+
+		deadline = timeval_ms() + timeout_ms;
+		keep_alive();
+	}
+
+	/* ask the algorithm to stop early, if we gave up */
+	if (retval != ERROR_OK)
+		target_write_u32(target, wp_addr, 0);
+
+	retval2 = target_wait_algorithm(target,
+			num_mem_params, mem_params,
+			num_reg_params, reg_params,
+			exit_point, timeout_ms, arch_info);
+
+	return (retval != ERROR_OK) ? retval : retval2;
+}
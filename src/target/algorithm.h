@@ -51,4 +51,13 @@ void init_reg_param(struct reg_param *param,
 		char *reg_name, uint32_t size, enum param_direction dir);
 void destroy_reg_param(struct reg_param *param);
 
+struct target;
+int target_run_fifo_algorithm(struct target *target,
+		uint8_t *buffer, uint32_t count, uint32_t block_size,
+		int num_mem_params, struct mem_param *mem_params,
+		int num_reg_params, struct reg_param *reg_params,
+		uint32_t fifo_start, uint32_t fifo_size,
+		uint32_t entry_point, uint32_t exit_point,
+		int timeout_ms, void *arch_info);
+
 #endif /* ALGORITHM_H */
@@ -164,6 +164,14 @@ struct arm {
 			uint32_t CRn, uint32_t CRm,
 			uint32_t value);
 
+	/** Core state saved while algorithms run, in algorithm_mode;
+	 * see target_begin_algorithm_session(). */
+	bool algorithm_session;
+	enum arm_mode algorithm_mode;
+	enum arm_state algorithm_core_state;
+	uint32_t algorithm_context[17];
+	uint32_t algorithm_cpsr;
+
 	void *arch_info;
 
 	/** For targets conforming to ARM Debug Interface v5,
@@ -215,6 +223,18 @@ int armv4_5_run_algorithm(struct target *target,
 		int num_reg_params, struct reg_param *reg_params,
 		uint32_t entry_point, uint32_t exit_point,
 		int timeout_ms, void *arch_info);
+int armv4_5_start_algorithm(struct target *target,
+		int num_mem_params, struct mem_param *mem_params,
+		int num_reg_params, struct reg_param *reg_params,
+		uint32_t entry_point, uint32_t exit_point,
+		void *arch_info);
+int armv4_5_wait_algorithm(struct target *target,
+		int num_mem_params, struct mem_param *mem_params,
+		int num_reg_params, struct reg_param *reg_params,
+		uint32_t exit_point, int timeout_ms,
+		void *arch_info);
+int armv4_5_begin_algorithm_session(struct target *target, void *arch_info);
+int armv4_5_end_algorithm_session(struct target *target, void *arch_info);
 int armv4_5_run_algorithm_inner(struct target *target,
 		int num_mem_params, struct mem_param *mem_params,
 		int num_reg_params, struct reg_param *reg_params,
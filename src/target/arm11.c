@@ -1422,6 +1422,8 @@ struct target_type arm11_target = {
 	.remove_breakpoint =	arm11_remove_breakpoint,
 
 	.run_algorithm =	armv4_5_run_algorithm,
+	.begin_algorithm_session =	armv4_5_begin_algorithm_session,
+	.end_algorithm_session =	armv4_5_end_algorithm_session,
 
 	.commands =		arm11_command_handlers,
 	.target_create =	arm11_target_create,
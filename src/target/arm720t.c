@@ -600,6 +600,7 @@ struct target_type arm720t_target =
 
 	.read_memory = arm720t_read_memory,
 	.write_memory = arm7_9_write_memory,
+	.write_memory_vector = arm7_9_write_memory_vector,
 	.read_phys_memory = arm720t_read_phys_memory,
 	.write_phys_memory = arm720t_write_phys_memory,
 	.mmu = arm720_mmu,
@@ -611,6 +612,8 @@ struct target_type arm720t_target =
 	.blank_check_memory = arm_blank_check_memory,
 
 	.run_algorithm = armv4_5_run_algorithm,
+	.begin_algorithm_session = armv4_5_begin_algorithm_session,
+	.end_algorithm_session = armv4_5_end_algorithm_session,
 
 	.add_breakpoint = arm7_9_add_breakpoint,
 	.remove_breakpoint = arm7_9_remove_breakpoint,
@@ -2255,15 +2255,55 @@ static int arm7_9_write_core_reg(struct target *target, struct reg *r,
 	return jtag_execute_queue();
 }
 
-int arm7_9_read_memory(struct target *target, uint32_t address, uint32_t size, uint32_t count, uint8_t *buffer)
+/* Finish a memory read: mark the scratch registers dirty, flush the
+ * queue and check for a data abort.
+ */
+static int arm7_9_read_memory_done(struct target *target, int last_reg,
+		uint32_t address, uint32_t size, uint32_t count)
 {
 	struct arm7_9_common *arm7_9 = target_to_arm7_9(target);
 	struct arm *armv4_5 = &arm7_9->armv4_5_common;
+	uint32_t cpsr;
+	int retval;
+	int i;
+
+	if (!is_arm_mode(armv4_5->core_mode))
+		return ERROR_FAIL;
+
+	for (i = 0; i <= last_reg; i++) {
+		struct reg *r = arm_reg_current(armv4_5, i);
+
+		r->dirty = r->valid;
+	}
+
+	arm7_9->read_xpsr(target, &cpsr, 0);
+	if ((retval = jtag_execute_queue()) != ERROR_OK)
+	{
+		LOG_ERROR("JTAG error while reading cpsr");
+		return ERROR_TARGET_DATA_ABORT;
+	}
+
+	if (((cpsr & 0x1f) == ARM_MODE_ABT) && (armv4_5->core_mode != ARM_MODE_ABT))
+	{
+		LOG_WARNING("memory read caused data abort (address: 0x%8.8" PRIx32 ", size: 0x%" PRIx32 ", count: 0x%" PRIx32 ")", address, size, count);
+
+		arm7_9->write_xpsr_im8(target,
+				buf_get_u32(armv4_5->cpsr->value, 0, 8)
+					& ~0x20, 0, 0);
+
+		return ERROR_TARGET_DATA_ABORT;
+	}
+
+	return ERROR_OK;
+}
+
+int arm7_9_read_memory(struct target *target, uint32_t address, uint32_t size, uint32_t count, uint8_t *buffer)
+{
+	struct arm7_9_common *arm7_9 = target_to_arm7_9(target);
 	uint32_t reg[16];
 	uint32_t num_accesses = 0;
 	int thisrun_accesses;
 	int i;
-	uint32_t cpsr;
 	int retval;
 	int last_reg = 0;
 
@@ -2401,6 +2441,100 @@ int arm7_9_read_memory(struct target *target, uint32_t address, uint32_t size, u
 			break;
 	}
 
+	return arm7_9_read_memory_done(target, last_reg, address, size, count);
+}
+
+int arm7_9_read_memory_vector(struct target *target,
+		struct target_memory_item *items, unsigned count)
+{
+	struct arm7_9_common *arm7_9 = target_to_arm7_9(target);
+	uint32_t reg[1];
+	uint32_t *regs[16];
+	unsigned i;
+	int retval = ERROR_OK;
+
+	if (target->state != TARGET_HALTED)
+	{
+		LOG_WARNING("target not halted");
+		return ERROR_TARGET_NOT_HALTED;
+	}
+
+	/* slow loads must be polled for, one by one */
+	if (!arm7_9->fast_memory_access)
+	{
+		for (i = 0; i < count && retval == ERROR_OK; i++)
+		{
+			uint8_t value_buf[4];
+
+			retval = arm7_9_read_memory(target, items[i].address,
+					items[i].size, 1, value_buf);
+			if (retval != ERROR_OK)
+				break;
+
+			switch (items[i].size) {
+			case 4:
+				items[i].value = target_buffer_get_u32(target, value_buf);
+				break;
+			case 2:
+				items[i].value = target_buffer_get_u16(target, value_buf);
+				break;
+			default:
+				items[i].value = value_buf[0];
+				break;
+			}
+		}
+		return retval;
+	}
+
+	memset(regs, 0, sizeof(regs));
+
+	/* queue r0 = address, a load into r1 and the read of r1 for each item */
+	for (i = 0; i < count; i++)
+	{
+		reg[0] = items[i].address;
+		arm7_9->write_core_regs(target, 0x1, reg);
+
+		switch (items[i].size) {
+		case 4:
+			arm7_9->load_word_regs(target, 0x2);
+			break;
+		case 2:
+			arm7_9->load_hword_reg(target, 1);
+			break;
+		default:
+			arm7_9->load_byte_reg(target, 1);
+			break;
+		}
+
+		retval = arm7_9_execute_fast_sys_speed(target);
+		if (retval != ERROR_OK)
+			return retval;
+
+		regs[1] = &items[i].value;
+		arm7_9->read_core_regs(target, 0x2, regs);
+	}
+
+	return arm7_9_read_memory_done(target, 1,
+			items[0].address, items[0].size, count);
+}
+
+/* Finish a memory write: restore DBGACK, mark the scratch registers
+ * dirty, flush the queue and check for a data abort.
+ */
+static int arm7_9_write_memory_done(struct target *target, int last_reg,
+		uint32_t address, uint32_t size, uint32_t count)
+{
+	struct arm7_9_common *arm7_9 = target_to_arm7_9(target);
+	struct arm *armv4_5 = &arm7_9->armv4_5_common;
+	struct reg *dbg_ctrl = &arm7_9->eice_cache->reg_list[EICE_DBG_CTRL];
+	uint32_t cpsr;
+	int retval;
+	int i;
+
+	/* Re-Set DBGACK */
+	buf_set_u32(dbg_ctrl->value, EICE_DBG_CONTROL_DBGACK, 1, 1);
+	embeddedice_store_reg(dbg_ctrl);
+
 	if (!is_arm_mode(armv4_5->core_mode))
 		return ERROR_FAIL;
 
@@ -2419,7 +2553,7 @@ int arm7_9_read_memory(struct target *target, uint32_t address, uint32_t size, u
 
 	if (((cpsr & 0x1f) == ARM_MODE_ABT) && (armv4_5->core_mode != ARM_MODE_ABT))
 	{
-		LOG_WARNING("memory read caused data abort (address: 0x%8.8" PRIx32 ", size: 0x%" PRIx32 ", count: 0x%" PRIx32 ")", address, size, count);
+		LOG_WARNING("memory write caused data abort (address: 0x%8.8" PRIx32 ", size: 0x%" PRIx32 ", count: 0x%" PRIx32 ")", address, size, count);
 
 		arm7_9->write_xpsr_im8(target,
 				buf_get_u32(armv4_5->cpsr->value, 0, 8)
@@ -2434,14 +2568,12 @@ int arm7_9_read_memory(struct target *target, uint32_t address, uint32_t size, u
 int arm7_9_write_memory(struct target *target, uint32_t address, uint32_t size, uint32_t count, uint8_t *buffer)
 {
 	struct arm7_9_common *arm7_9 = target_to_arm7_9(target);
-	struct arm *armv4_5 = &arm7_9->armv4_5_common;
 	struct reg *dbg_ctrl = &arm7_9->eice_cache->reg_list[EICE_DBG_CTRL];
 
 	uint32_t reg[16];
 	uint32_t num_accesses = 0;
 	int thisrun_accesses;
 	int i;
-	uint32_t cpsr;
 	int retval;
 	int last_reg = 0;
 
@@ -2620,38 +2752,78 @@ int arm7_9_write_memory(struct target *target, uint32_t address, uint32_t size,
 			break;
 	}
 
-	/* Re-Set DBGACK */
-	buf_set_u32(dbg_ctrl->value, EICE_DBG_CONTROL_DBGACK, 1, 1);
-	embeddedice_store_reg(dbg_ctrl);
-
-	if (!is_arm_mode(armv4_5->core_mode))
-		return ERROR_FAIL;
+	return arm7_9_write_memory_done(target, last_reg, address, size, count);
+}
 
-	for (i = 0; i <= last_reg; i++) {
-		struct reg *r = arm_reg_current(armv4_5, i);
+int arm7_9_write_memory_vector(struct target *target,
+		struct target_memory_item *items, unsigned count)
+{
+	struct arm7_9_common *arm7_9 = target_to_arm7_9(target);
+	struct reg *dbg_ctrl = &arm7_9->eice_cache->reg_list[EICE_DBG_CTRL];
+	uint32_t reg[2];
+	unsigned i;
+	int retval = ERROR_OK;
 
-		r->dirty = r->valid;
+	if (target->state != TARGET_HALTED)
+	{
+		LOG_WARNING("target not halted");
+		return ERROR_TARGET_NOT_HALTED;
 	}
 
-	arm7_9->read_xpsr(target, &cpsr, 0);
-	if ((retval = jtag_execute_queue()) != ERROR_OK)
+	/* slow stores must be polled for, one by one */
+	if (!arm7_9->fast_memory_access)
 	{
-		LOG_ERROR("JTAG error while reading cpsr");
-		return ERROR_TARGET_DATA_ABORT;
+		for (i = 0; i < count && retval == ERROR_OK; i++)
+		{
+			uint8_t value_buf[4];
+
+			switch (items[i].size) {
+			case 4:
+				target_buffer_set_u32(target, value_buf, items[i].value);
+				break;
+			case 2:
+				target_buffer_set_u16(target, value_buf, items[i].value);
+				break;
+			default:
+				value_buf[0] = items[i].value;
+				break;
+			}
+			retval = arm7_9_write_memory(target, items[i].address,
+					items[i].size, 1, value_buf);
+		}
+		return retval;
 	}
 
-	if (((cpsr & 0x1f) == ARM_MODE_ABT) && (armv4_5->core_mode != ARM_MODE_ABT))
+	/* Clear DBGACK, to make sure memory fetches work as expected */
+	buf_set_u32(dbg_ctrl->value, EICE_DBG_CONTROL_DBGACK, 1, 0);
+	embeddedice_store_reg(dbg_ctrl);
+
+	/* queue r0 = address, r1 = value and a store for each item */
+	for (i = 0; i < count; i++)
 	{
-		LOG_WARNING("memory write caused data abort (address: 0x%8.8" PRIx32 ", size: 0x%" PRIx32 ", count: 0x%" PRIx32 ")", address, size, count);
+		reg[0] = items[i].address;
+		reg[1] = items[i].value;
+		arm7_9->write_core_regs(target, 0x3, reg);
 
-		arm7_9->write_xpsr_im8(target,
-				buf_get_u32(armv4_5->cpsr->value, 0, 8)
-					& ~0x20, 0, 0);
+		switch (items[i].size) {
+		case 4:
+			arm7_9->store_word_regs(target, 0x2);
+			break;
+		case 2:
+			arm7_9->store_hword_reg(target, 1);
+			break;
+		default:
+			arm7_9->store_byte_reg(target, 1);
+			break;
+		}
 
-		return ERROR_TARGET_DATA_ABORT;
+		retval = arm7_9_execute_fast_sys_speed(target);
+		if (retval != ERROR_OK)
+			return retval;
 	}
 
-	return ERROR_OK;
+	return arm7_9_write_memory_done(target, 1,
+			items[0].address, items[0].size, count);
 }
 
 static int dcc_count;
@@ -1801,6 +1801,8 @@ struct target_type arm920t_target =
 	.blank_check_memory = arm_blank_check_memory,
 
 	.run_algorithm = armv4_5_run_algorithm,
+	.begin_algorithm_session = armv4_5_begin_algorithm_session,
+	.end_algorithm_session = armv4_5_end_algorithm_session,
 
 	.add_breakpoint = arm7_9_add_breakpoint,
 	.remove_breakpoint = arm7_9_remove_breakpoint,
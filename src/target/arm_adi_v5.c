@@ -189,6 +189,82 @@ int mem_ap_read_u32(struct adiv5_dap *dap, uint32_t address,
 	return dap_queue_ap_read(dap, AP_REG_BD0 | (address & 0xC), value);
 }
 
+/* Set up TAR and CSW for one item of @a size bytes, and pick the data
+ * register to access.  The banked registers only do word accesses at
+ * TAR[31:4] + 4n, so bytes and half-words go through DRW with TAR set
+ * to their exact address.
+ */
+static int mem_ap_setup_item(struct adiv5_dap *dap, uint32_t address,
+		uint32_t size, unsigned *reg)
+{
+	uint32_t csw;
+
+	switch (size) {
+	case 4:
+		*reg = AP_REG_BD0 | (address & 0xC);
+		return dap_setup_accessport(dap, CSW_32BIT | CSW_ADDRINC_OFF,
+				address & 0xFFFFFFF0);
+	case 2:
+		csw = CSW_16BIT;
+		break;
+	case 1:
+		csw = CSW_8BIT;
+		break;
+	default:
+		return ERROR_INVALID_ARGUMENTS;
+	}
+
+	*reg = AP_REG_DRW;
+	return dap_setup_accessport(dap, csw | CSW_ADDRINC_OFF, address);
+}
+
+/**
+ * Asynchronous (queued) read of a byte, half-word or word.
+ *
+ * @param dap The DAP connected to the MEM-AP performing the read.
+ * @param address Address of the item to read, aligned to @a size.
+ * @param size 1, 2 or 4 bytes.
+ * @param value points to where the 32-bit data bus value will be stored
+ *	when the transaction queue is flushed; the item is in the byte
+ *	lane selected by the low bits of @a address.
+ *
+ * @return ERROR_OK for success.  Otherwise a fault code.
+ */
+int mem_ap_read_sized(struct adiv5_dap *dap, uint32_t address,
+		uint32_t size, uint32_t *value)
+{
+	unsigned reg;
+	int retval = mem_ap_setup_item(dap, address, size, &reg);
+
+	if (retval != ERROR_OK)
+		return retval;
+
+	return dap_queue_ap_read(dap, reg, value);
+}
+
+/**
+ * Asynchronous (queued) write of a byte, half-word or word.
+ *
+ * @param dap The DAP connected to the MEM-AP performing the write.
+ * @param address Address of the item to write, aligned to @a size.
+ * @param size 1, 2 or 4 bytes.
+ * @param value The item, in host byte order; it is moved to the byte
+ *	lane selected by the low bits of @a address.
+ *
+ * @return ERROR_OK for success.  Otherwise a fault code.
+ */
+int mem_ap_write_sized(struct adiv5_dap *dap, uint32_t address,
+		uint32_t size, uint32_t value)
+{
+	unsigned reg;
+	int retval = mem_ap_setup_item(dap, address, size, &reg);
+
+	if (retval != ERROR_OK)
+		return retval;
+
+	return dap_queue_ap_write(dap, reg, value << (8 * (address & 3)));
+}
+
 /**
  * Synchronous read of a word from memory or a system register.
  * As a side effect, this flushes any queued transactions.
@@ -298,46 +374,49 @@ int mem_ap_write_buf_u32(struct adiv5_dap *dap, uint8_t *buffer, int count, uint
 		}
 	}
 
-	while (wcount > 0)
+	do
 	{
-		/* Adjust to write blocks within boundaries aligned to the TAR autoincremnent size*/
-		blocksize = max_tar_block_size(dap->tar_autoincr_block, address);
-		if (wcount < blocksize)
-			blocksize = wcount;
+		uint32_t block_address = address;
+		uint8_t *block_buffer = buffer;
 
-		/* handle unaligned data at 4k boundary */
-		if (blocksize == 0)
-			blocksize = 1;
+		/* Queue the whole buffer, one block within the TAR
+		 * autoincrement boundaries at a time, then run it all
+		 * at once.
+		 */
+		for (wcount = count; wcount > 0; wcount -= blocksize)
+		{
+			blocksize = max_tar_block_size(dap->tar_autoincr_block,
+					block_address);
+			if (wcount < blocksize)
+				blocksize = wcount;
 
-		retval = dap_setup_accessport(dap, CSW_32BIT | CSW_ADDRINC_SINGLE, address);
-		if (retval != ERROR_OK)
-			return retval;
+			/* handle unaligned data at 4k boundary */
+			if (blocksize == 0)
+				blocksize = 1;
 
-		for (writecount = 0; writecount < blocksize; writecount++)
-		{
-			retval = dap_queue_ap_write(dap, AP_REG_DRW,
-				*(uint32_t *) ((void *) (buffer + 4 * writecount)));
+			retval = dap_setup_accessport(dap, CSW_32BIT | CSW_ADDRINC_SINGLE,
+					block_address);
 			if (retval != ERROR_OK)
-				break;
-		}
+				return retval;
 
-		if ((retval = dap_run(dap)) == ERROR_OK)
-		{
-			wcount = wcount - blocksize;
-			address = address + 4 * blocksize;
-			buffer = buffer + 4 * blocksize;
-		}
-		else
-		{
-			errorcount++;
-		}
+			for (writecount = 0; writecount < blocksize; writecount++)
+			{
+				retval = dap_queue_ap_write(dap, AP_REG_DRW,
+					*(uint32_t *) ((void *) (block_buffer + 4 * writecount)));
+				if (retval != ERROR_OK)
+					return retval;
+			}
 
-		if (errorcount > 1)
-		{
-			LOG_WARNING("Block write error address 0x%" PRIx32 ", wcount 0x%x", address, wcount);
-			return retval;
+			block_address += 4 * blocksize;
+			block_buffer += 4 * blocksize;
 		}
-	}
+
+		/* on error, try the whole buffer once more */
+		retval = dap_run(dap);
+	} while (retval != ERROR_OK && ++errorcount <= 1);
+
+	if (retval != ERROR_OK)
+		LOG_WARNING("Block write error address 0x%" PRIx32 ", wcount 0x%x", address, count);
 
 	return retval;
 }
@@ -561,18 +640,49 @@ int mem_ap_write_buf_u8(struct adiv5_dap *dap, uint8_t *buffer, int count, uint3
 	return retval;
 }
 
-/* FIXME don't import ... this is a temporary workaround for the
- * mem_ap_read_buf_u32() mess, until it's no longer JTAG-specific.
+/* Queue @a count DRW reads into @a buffer.  Transports which can't
+ * pipeline them read one word at a time, in host byte order; the caller
+ * fixes that up once the data has arrived.
+ */
+static int mem_ap_queue_read_block(struct adiv5_dap *dap,
+		uint32_t count, uint8_t *buffer)
+{
+	int retval = ERROR_OK;
+	uint32_t i;
+
+	if (dap->ops->queue_ap_read_block)
+		return dap->ops->queue_ap_read_block(dap, AP_REG_DRW,
+				count, buffer);
+
+	for (i = 0; i < count && retval == ERROR_OK; i++)
+		retval = dap_queue_ap_read(dap, AP_REG_DRW,
+				(uint32_t *) ((void *) (buffer + 4 * i)));
+	return retval;
+}
+
+/* Put words read by mem_ap_queue_read_block() into target byte order,
+ * once the queue has been run.
  */
-extern int adi_jtag_dp_scan(struct adiv5_dap *dap,
-		uint8_t instr, uint8_t reg_addr, uint8_t RnW,
-		uint8_t *outvalue, uint8_t *invalue, uint8_t *ack);
+static void mem_ap_read_block_done(struct adiv5_dap *dap,
+		uint32_t count, uint8_t *buffer)
+{
+	uint32_t i;
+
+	if (dap->ops->queue_ap_read_block)
+		return;
+
+	for (i = 0; i < count; i++)
+	{
+		uint32_t data = *(uint32_t *) ((void *) (buffer + 4 * i));
+		h_u32_to_le(buffer + 4 * i, data);
+	}
+}
 
 /**
  * Synchronously read a block of 32-bit words into a buffer
  * @param dap The DAP connected to the MEM-AP.
- * @param buffer where the words will be stored (in host byte order).
- * @param count How many words to read.
+ * @param buffer where the words will be stored (in target byte order).
+ * @param count How many bytes to read.
  * @param address Memory address from which to read words; all the
  *	words must be readable by the currently selected MEM-AP.
  */
@@ -584,79 +694,53 @@ int mem_ap_read_buf_u32(struct adiv5_dap *dap, uint8_t *buffer,
 	uint8_t* pBuffer = buffer;
 
 	count >>= 2;
-	wcount = count;
 
-	while (wcount > 0)
+	do
 	{
-		/* Adjust to read blocks within boundaries aligned to the
-		 * TAR autoincrement size (at least 2^10).  Autoincrement
+		uint32_t block_address = address;
+		uint8_t *block_buffer = buffer;
+
+		/* Queue the whole buffer, in blocks within boundaries
+		 * aligned to the TAR autoincrement size (at least 2^10),
+		 * and collect it with a single round trip.  Autoincrement
 		 * mode avoids an extra per-word roundtrip to update TAR.
 		 */
-		blocksize = max_tar_block_size(dap->tar_autoincr_block,
-				address);
-		if (wcount < blocksize)
-			blocksize = wcount;
-
-		/* handle unaligned data at 4k boundary */
-		if (blocksize == 0)
-			blocksize = 1;
+		for (wcount = count; wcount > 0; wcount -= blocksize)
+		{
+			blocksize = max_tar_block_size(dap->tar_autoincr_block,
+					block_address);
+			if (wcount < blocksize)
+				blocksize = wcount;
 
-		retval = dap_setup_accessport(dap, CSW_32BIT | CSW_ADDRINC_SINGLE,
-				address);
-		if (retval != ERROR_OK)
-			return retval;
+			/* handle unaligned data at 4k boundary */
+			if (blocksize == 0)
+				blocksize = 1;
 
-		/* FIXME remove these three calls to adi_jtag_dp_scan(),
-		 * so this routine becomes transport-neutral.  Be careful
-		 * not to cause performance problems with JTAG; would it
-		 * suffice to loop over dap_queue_ap_read(), or would that
-		 * be slower when JTAG is the chosen transport?
-		 */
+			retval = dap_setup_accessport(dap, CSW_32BIT | CSW_ADDRINC_SINGLE,
+					block_address);
+			if (retval != ERROR_OK)
+				return retval;
 
-		/* Scan out first read */
-		retval = adi_jtag_dp_scan(dap, JTAG_DP_APACC, AP_REG_DRW,
-				DPAP_READ, 0, NULL, NULL);
-		if (retval != ERROR_OK)
-			return retval;
-		for (readcount = 0; readcount < blocksize - 1; readcount++)
-		{
-			/* Scan out next read; scan in posted value for the
-			 * previous one.  Assumes read is acked "OK/FAULT",
-			 * and CTRL_STAT says that meant "OK".
-			 */
-			retval = adi_jtag_dp_scan(dap, JTAG_DP_APACC, AP_REG_DRW,
-					DPAP_READ, 0, buffer + 4 * readcount,
-					&dap->ack);
+			retval = mem_ap_queue_read_block(dap, blocksize, block_buffer);
 			if (retval != ERROR_OK)
 				return retval;
-		}
 
-		/* Scan in last posted value; RDBUFF has no other effect,
-		 * assuming ack is OK/FAULT and CTRL_STAT says "OK".
-		 */
-		retval = adi_jtag_dp_scan(dap, JTAG_DP_DPACC, DP_RDBUFF,
-				DPAP_READ, 0, buffer + 4 * readcount,
-				&dap->ack);
-		if (retval != ERROR_OK)
-			return retval;
+			block_address += 4 * blocksize;
+			block_buffer += 4 * blocksize;
+		}
 
+		/* on error, try the whole buffer once more */
 		retval = dap_run(dap);
-		if (retval != ERROR_OK)
-		{
-			errorcount++;
-			if (errorcount <= 1)
-			{
-				/* try again */
-				continue;
-			}
-			LOG_WARNING("Block read error address 0x%" PRIx32, address);
-			return retval;
-		}
-		wcount = wcount - blocksize;
-		address += 4 * blocksize;
-		buffer += 4 * blocksize;
+	} while (retval != ERROR_OK && ++errorcount <= 1);
+
+	if (retval != ERROR_OK)
+	{
+		LOG_WARNING("Block read error address 0x%" PRIx32, address);
+		return retval;
 	}
 
+	mem_ap_read_block_done(dap, count, buffer);
+
 	/* if we have an unaligned access - reorder data */
 	if (adr & 0x3u)
 	{
@@ -679,6 +763,37 @@ int mem_ap_read_buf_u32(struct adiv5_dap *dap, uint8_t *buffer,
 	return retval;
 }
 
+/**
+ * Synchronously read 32-bit words from a single address, such as a FIFO
+ * or a sampling register, into a buffer.
+ * @param dap The DAP connected to the MEM-AP.
+ * @param buffer where the words will be stored (in target byte order).
+ * @param count How many bytes to read.
+ * @param address Word aligned address to read repeatedly.
+ */
+int mem_ap_read_buf_noincr_u32(struct adiv5_dap *dap, uint8_t *buffer,
+		int count, uint32_t address)
+{
+	int retval;
+
+	count >>= 2;
+
+	retval = dap_setup_accessport(dap, CSW_32BIT | CSW_ADDRINC_OFF, address);
+	if (retval != ERROR_OK)
+		return retval;
+
+	retval = mem_ap_queue_read_block(dap, count, buffer);
+	if (retval != ERROR_OK)
+		return retval;
+
+	retval = dap_run(dap);
+	if (retval != ERROR_OK)
+		return retval;
+
+	mem_ap_read_block_done(dap, count, buffer);
+	return ERROR_OK;
+}
+
 static int mem_ap_read_buf_packed_u16(struct adiv5_dap *dap,
 		uint8_t *buffer, int count, uint32_t address)
 {
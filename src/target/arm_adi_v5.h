@@ -32,12 +32,6 @@
 
 #include "arm_jtag.h"
 
-/* FIXME remove these JTAG-specific decls when mem_ap_read_buf_u32()
- * is no longer JTAG-specific
- */
-#define JTAG_DP_DPACC		0xA
-#define JTAG_DP_APACC		0xB
-
 /* three-bit ACK values for SWD access (sent LSB first) */
 #define SWD_ACK_OK		0x4
 #define SWD_ACK_WAIT		0x2
@@ -207,6 +201,12 @@ struct dap_ops {
 	/** AP register read. */
 	int (*queue_ap_read)(struct adiv5_dap *dap, unsigned reg,
 			uint32_t *data);
+	/** Optional: @a count reads of one AP register, such as DRW with
+	 * TAR auto-increment, stored in target (little endian) byte order.
+	 * Transports which can pipeline posted reads should provide this.
+	 */
+	int (*queue_ap_read_block)(struct adiv5_dap *dap, unsigned reg,
+			uint32_t count, uint8_t *buffer);
 	/** AP register write. */
 	int (*queue_ap_write)(struct adiv5_dap *dap, unsigned reg,
 			uint32_t data);
@@ -354,6 +354,10 @@ int dap_setup_accessport(struct adiv5_dap *swjdp,
 /* Queued MEM-AP memory mapped single word transfers */
 int mem_ap_read_u32(struct adiv5_dap *swjdp, uint32_t address, uint32_t *value);
 int mem_ap_write_u32(struct adiv5_dap *swjdp, uint32_t address, uint32_t value);
+int mem_ap_read_sized(struct adiv5_dap *swjdp, uint32_t address,
+		uint32_t size, uint32_t *value);
+int mem_ap_write_sized(struct adiv5_dap *swjdp, uint32_t address,
+		uint32_t size, uint32_t value);
 
 /* Synchronous MEM-AP memory mapped single word transfers */
 int mem_ap_read_atomic_u32(struct adiv5_dap *swjdp,
@@ -368,6 +372,8 @@ int mem_ap_read_buf_u16(struct adiv5_dap *swjdp,
 		uint8_t *buffer, int count, uint32_t address);
 int mem_ap_read_buf_u32(struct adiv5_dap *swjdp,
 		uint8_t *buffer, int count, uint32_t address);
+int mem_ap_read_buf_noincr_u32(struct adiv5_dap *swjdp,
+		uint8_t *buffer, int count, uint32_t address);
 
 int mem_ap_write_buf_u8(struct adiv5_dap *swjdp,
 		uint8_t *buffer, int count, uint32_t address);
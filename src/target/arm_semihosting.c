@@ -66,11 +66,24 @@ static int open_modeflags[12] = {
 static int do_semihosting(struct target *target)
 {
 	struct arm *arm = target_to_arm(target);
-	uint32_t r0 = buf_get_u32(arm->core_cache->reg_list[0].value, 0, 32);
-	uint32_t r1 = buf_get_u32(arm->core_cache->reg_list[1].value, 0, 32);
+	struct reg *r;
+	uint32_t r0, r1;
 	uint8_t params[16];
 	int retval, result;
 
+	/* Cortex-M debug entry leaves these to be read on demand */
+	for (r = arm->core_cache->reg_list; r < arm->core_cache->reg_list + 2; r++)
+	{
+		if (!r->valid)
+		{
+			retval = r->type->get(r);
+			if (retval != ERROR_OK)
+				return retval;
+		}
+	}
+	r0 = buf_get_u32(arm->core_cache->reg_list[0].value, 0, 32);
+	r1 = buf_get_u32(arm->core_cache->reg_list[1].value, 0, 32);
+
 	/*
 	 * TODO: lots of security issues are not considered yet, such as:
 	 * - no validation on target provided file descriptors
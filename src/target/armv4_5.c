@@ -1101,24 +1101,10 @@ static int armv4_5_run_algorithm_completion(struct target *target, uint32_t exit
 	return ERROR_OK;
 }
 
-int armv4_5_run_algorithm_inner(struct target *target,
-		int num_mem_params, struct mem_param *mem_params,
-		int num_reg_params, struct reg_param *reg_params,
-		uint32_t entry_point, uint32_t exit_point,
-		int timeout_ms, void *arch_info,
-		int (*run_it)(struct target *target, uint32_t exit_point,
-				int timeout_ms, void *arch_info))
+static int armv4_5_check_algorithm(struct target *target, void *arch_info)
 {
 	struct arm *armv4_5 = target_to_arm(target);
 	struct arm_algorithm *arm_algorithm_info = arch_info;
-	enum arm_state core_state = armv4_5->core_state;
-	uint32_t context[17];
-	uint32_t cpsr;
-	int exit_breakpoint_size = 0;
-	int i;
-	int retval = ERROR_OK;
-
-	LOG_DEBUG("Running algorithm");
 
 	if (arm_algorithm_info->common_magic != ARM_COMMON_MAGIC)
 	{
@@ -1138,28 +1124,91 @@ int armv4_5_run_algorithm_inner(struct target *target,
 		return ERROR_FAIL;
 	}
 
-	/* armv5 and later can terminate with BKPT instruction; less overhead */
-	if (!exit_point && armv4_5->is_armv4)
-	{
-		LOG_ERROR("ARMv4 target needs HW breakpoint location");
-		return ERROR_FAIL;
-	}
+	return ERROR_OK;
+}
+
+/* save r0..pc, cpsr-or-spsr, and then cpsr-for-sure;
+ * they'll be restored later.
+ */
+static void armv4_5_save_algorithm_context(struct target *target,
+		enum arm_mode mode)
+{
+	struct arm *armv4_5 = target_to_arm(target);
+	int i;
 
-	/* save r0..pc, cpsr-or-spsr, and then cpsr-for-sure;
-	 * they'll be restored later.
-	 */
 	for (i = 0; i <= 16; i++)
 	{
 		struct reg *r;
 
-		r = &ARMV4_5_CORE_REG_MODE(armv4_5->core_cache,
-				arm_algorithm_info->core_mode, i);
+		r = &ARMV4_5_CORE_REG_MODE(armv4_5->core_cache, mode, i);
 		if (!r->valid)
-			armv4_5->read_core_reg(target, r, i,
-					arm_algorithm_info->core_mode);
-		context[i] = buf_get_u32(r->value, 0, 32);
+			armv4_5->read_core_reg(target, r, i, mode);
+		armv4_5->algorithm_context[i] = buf_get_u32(r->value, 0, 32);
 	}
-	cpsr = buf_get_u32(armv4_5->cpsr->value, 0, 32);
+	armv4_5->algorithm_cpsr = buf_get_u32(armv4_5->cpsr->value, 0, 32);
+	armv4_5->algorithm_core_state = armv4_5->core_state;
+	armv4_5->algorithm_mode = mode;
+}
+
+/* restore everything we saved before (17 or 18 registers) */
+static void armv4_5_restore_algorithm_context(struct target *target)
+{
+	struct arm *armv4_5 = target_to_arm(target);
+	enum arm_mode mode = armv4_5->algorithm_mode;
+	int i;
+
+	for (i = 0; i <= 16; i++)
+	{
+		uint32_t regvalue;
+		regvalue = buf_get_u32(ARMV4_5_CORE_REG_MODE(armv4_5->core_cache, mode, i).value, 0, 32);
+		if (regvalue != armv4_5->algorithm_context[i])
+		{
+			LOG_DEBUG("restoring register %s with value 0x%8.8" PRIx32 "", ARMV4_5_CORE_REG_MODE(armv4_5->core_cache, mode, i).name, armv4_5->algorithm_context[i]);
+			buf_set_u32(ARMV4_5_CORE_REG_MODE(armv4_5->core_cache, mode, i).value, 0, 32, armv4_5->algorithm_context[i]);
+			ARMV4_5_CORE_REG_MODE(armv4_5->core_cache, mode, i).valid = 1;
+			ARMV4_5_CORE_REG_MODE(armv4_5->core_cache, mode, i).dirty = 1;
+		}
+	}
+
+	arm_set_cpsr(armv4_5, armv4_5->algorithm_cpsr);
+	armv4_5->cpsr->dirty = 1;
+
+	armv4_5->core_state = armv4_5->algorithm_core_state;
+}
+
+/**
+ * Starts an ARM or Thumb algorithm in the target, without waiting for it;
+ * use armv4_5_wait_algorithm() to collect its results.
+ */
+int armv4_5_start_algorithm(struct target *target,
+		int num_mem_params, struct mem_param *mem_params,
+		int num_reg_params, struct reg_param *reg_params,
+		uint32_t entry_point, uint32_t exit_point,
+		void *arch_info)
+{
+	struct arm *armv4_5 = target_to_arm(target);
+	struct arm_algorithm *arm_algorithm_info = arch_info;
+	int exit_breakpoint_size = 0;
+	int i;
+	int retval = ERROR_OK;
+
+	LOG_DEBUG("Running algorithm");
+
+	retval = armv4_5_check_algorithm(target, arch_info);
+	if (retval != ERROR_OK)
+		return retval;
+
+	/* armv5 and later can terminate with BKPT instruction; less overhead */
+	if (!exit_point && armv4_5->is_armv4)
+	{
+		LOG_ERROR("ARMv4 target needs HW breakpoint location");
+		return ERROR_FAIL;
+	}
+
+	/* within a session, the context was saved once, up front */
+	if (!armv4_5->algorithm_session)
+		armv4_5_save_algorithm_context(target,
+				arm_algorithm_info->core_mode);
 
 	for (i = 0; i < num_mem_params; i++)
 	{
@@ -1221,10 +1270,23 @@ int armv4_5_run_algorithm_inner(struct target *target,
 
 	if ((retval = target_resume(target, 0, entry_point, 1, 1)) != ERROR_OK)
 	{
+		if (exit_point)
+			breakpoint_remove(target, exit_point);
 		return retval;
 	}
+
+	return ERROR_OK;
+}
+
+/* collect the results of an algorithm which has stopped, or failed */
+static int armv4_5_finish_algorithm(struct target *target,
+		int num_mem_params, struct mem_param *mem_params,
+		int num_reg_params, struct reg_param *reg_params,
+		uint32_t exit_point, int retval)
+{
+	struct arm *armv4_5 = target_to_arm(target);
 	int retvaltemp;
-	retval = run_it(target, exit_point, timeout_ms, arch_info);
+	int i;
 
 	if (exit_point)
 		breakpoint_remove(target, exit_point);
@@ -1265,26 +1327,53 @@ int armv4_5_run_algorithm_inner(struct target *target,
 		}
 	}
 
-	/* restore everything we saved before (17 or 18 registers) */
-	for (i = 0; i <= 16; i++)
-	{
-		uint32_t regvalue;
-		regvalue = buf_get_u32(ARMV4_5_CORE_REG_MODE(armv4_5->core_cache, arm_algorithm_info->core_mode, i).value, 0, 32);
-		if (regvalue != context[i])
-		{
-			LOG_DEBUG("restoring register %s with value 0x%8.8" PRIx32 "", ARMV4_5_CORE_REG_MODE(armv4_5->core_cache, arm_algorithm_info->core_mode, i).name, context[i]);
-			buf_set_u32(ARMV4_5_CORE_REG_MODE(armv4_5->core_cache, arm_algorithm_info->core_mode, i).value, 0, 32, context[i]);
-			ARMV4_5_CORE_REG_MODE(armv4_5->core_cache, arm_algorithm_info->core_mode, i).valid = 1;
-			ARMV4_5_CORE_REG_MODE(armv4_5->core_cache, arm_algorithm_info->core_mode, i).dirty = 1;
-		}
-	}
+	if (!armv4_5->algorithm_session)
+		armv4_5_restore_algorithm_context(target);
 
-	arm_set_cpsr(armv4_5, cpsr);
-	armv4_5->cpsr->dirty = 1;
+	return retval;
+}
 
-	armv4_5->core_state = core_state;
+/** Waits for an algorithm started by armv4_5_start_algorithm() to finish. */
+int armv4_5_wait_algorithm(struct target *target,
+		int num_mem_params, struct mem_param *mem_params,
+		int num_reg_params, struct reg_param *reg_params,
+		uint32_t exit_point, int timeout_ms,
+		void *arch_info)
+{
+	int retval;
 
-	return retval;
+	retval = armv4_5_run_algorithm_completion(target, exit_point,
+			timeout_ms, arch_info);
+
+	return armv4_5_finish_algorithm(target,
+			num_mem_params, mem_params,
+			num_reg_params, reg_params,
+			exit_point, retval);
+}
+
+int armv4_5_run_algorithm_inner(struct target *target,
+		int num_mem_params, struct mem_param *mem_params,
+		int num_reg_params, struct reg_param *reg_params,
+		uint32_t entry_point, uint32_t exit_point,
+		int timeout_ms, void *arch_info,
+		int (*run_it)(struct target *target, uint32_t exit_point,
+				int timeout_ms, void *arch_info))
+{
+	int retval;
+
+	retval = armv4_5_start_algorithm(target,
+			num_mem_params, mem_params,
+			num_reg_params, reg_params,
+			entry_point, exit_point, arch_info);
+	if (retval != ERROR_OK)
+		return retval;
+
+	retval = run_it(target, exit_point, timeout_ms, arch_info);
+
+	return armv4_5_finish_algorithm(target,
+			num_mem_params, mem_params,
+			num_reg_params, reg_params,
+			exit_point, retval);
 }
 
 int armv4_5_run_algorithm(struct target *target, int num_mem_params, struct mem_param *mem_params, int num_reg_params, struct reg_param *reg_params, uint32_t entry_point, uint32_t exit_point, int timeout_ms, void *arch_info)
@@ -1292,6 +1381,40 @@ int armv4_5_run_algorithm(struct target *target, int num_mem_params, struct mem_
 	return armv4_5_run_algorithm_inner(target, num_mem_params, mem_params, num_reg_params, reg_params, entry_point, exit_point, timeout_ms, arch_info, armv4_5_run_algorithm_completion);
 }
 
+/**
+ * Saves the core state once for a series of armv4_5_run_algorithm() calls,
+ * which then only load their parameters; armv4_5_end_algorithm_session()
+ * restores it.
+ */
+int armv4_5_begin_algorithm_session(struct target *target, void *arch_info)
+{
+	struct arm *armv4_5 = target_to_arm(target);
+	struct arm_algorithm *arm_algorithm_info = arch_info;
+	int retval;
+
+	retval = armv4_5_check_algorithm(target, arch_info);
+	if (retval != ERROR_OK)
+		return retval;
+
+	armv4_5_save_algorithm_context(target, arm_algorithm_info->core_mode);
+	armv4_5->algorithm_session = true;
+
+	return ERROR_OK;
+}
+
+int armv4_5_end_algorithm_session(struct target *target, void *arch_info)
+{
+	struct arm *armv4_5 = target_to_arm(target);
+
+	if (!armv4_5->algorithm_session)
+		return ERROR_OK;
+
+	armv4_5->algorithm_session = false;
+	armv4_5_restore_algorithm_context(target);
+
+	return ERROR_OK;
+}
+
 /**
  * Runs ARM code in the target to calculate a CRC32 checksum.
  *
@@ -287,17 +287,11 @@ int armv7m_get_gdb_reg_list(struct target *target, struct reg **reg_list[], int
 	return ERROR_OK;
 }
 
-/* run to exit point. return error if exit point was not reached. */
-static int armv7m_run_and_wait(struct target *target, uint32_t entry_point, int timeout_ms, uint32_t exit_point, struct armv7m_common *armv7m)
+/* wait for the exit point. return error if exit point was not reached. */
+static int armv7m_wait_for_exit(struct target *target, int timeout_ms, uint32_t exit_point, struct armv7m_common *armv7m)
 {
 	uint32_t pc;
 	int retval;
-	/* This code relies on the target specific  resume() and  poll()->debug_entry()
-	 * sequence to write register values to the processor and the read them back */
-	if ((retval = target_resume(target, 0, entry_point, 1, 1)) != ERROR_OK)
-	{
-		return retval;
-	}
 
 	retval = target_wait_state(target, TARGET_HALTED, timeout_ms);
 	/* If the target fails to halt due to the breakpoint, force a halt */
@@ -322,21 +316,9 @@ static int armv7m_run_and_wait(struct target *target, uint32_t entry_point, int
 	return ERROR_OK;
 }
 
-/** Runs a Thumb algorithm in the target. */
-int armv7m_run_algorithm(struct target *target,
-	int num_mem_params, struct mem_param *mem_params,
-	int num_reg_params, struct reg_param *reg_params,
-	uint32_t entry_point, uint32_t exit_point,
-	int timeout_ms, void *arch_info)
+static int armv7m_check_algorithm(struct target *target, void *arch_info)
 {
-	struct armv7m_common *armv7m = target_to_armv7m(target);
 	struct armv7m_algorithm *armv7m_algorithm_info = arch_info;
-	enum armv7m_mode core_mode = armv7m->core_mode;
-	int retval = ERROR_OK;
-	uint32_t context[ARMV7M_NUM_REGS];
-
-	/* NOTE: armv7m_run_algorithm requires that each algorithm uses a software breakpoint
-	 * at the exit point */
 
 	if (armv7m_algorithm_info->common_magic != ARMV7M_COMMON_MAGIC)
 	{
@@ -350,14 +332,70 @@ int armv7m_run_algorithm(struct target *target,
 		return ERROR_TARGET_NOT_HALTED;
 	}
 
+	return ERROR_OK;
+}
+
+static void armv7m_save_algorithm_context(struct target *target)
+{
+	struct armv7m_common *armv7m = target_to_armv7m(target);
+
 	/* refresh core register cache */
 	/* Not needed if core register cache is always consistent with target process state */
 	for (unsigned i = 0; i < ARMV7M_NUM_REGS; i++)
 	{
 		if (!armv7m->core_cache->reg_list[i].valid)
 			armv7m->read_core_reg(target, i);
-		context[i] = buf_get_u32(armv7m->core_cache->reg_list[i].value, 0, 32);
+		armv7m->algorithm_context[i] = buf_get_u32(armv7m->core_cache->reg_list[i].value, 0, 32);
 	}
+	armv7m->algorithm_core_mode = armv7m->core_mode;
+}
+
+static void armv7m_restore_algorithm_context(struct target *target)
+{
+	struct armv7m_common *armv7m = target_to_armv7m(target);
+
+	for (int i = ARMV7M_NUM_REGS - 1; i >= 0; i--)
+	{
+		uint32_t regvalue;
+		regvalue = buf_get_u32(armv7m->core_cache->reg_list[i].value, 0, 32);
+		if (regvalue != armv7m->algorithm_context[i])
+		{
+			LOG_DEBUG("restoring register %s with value 0x%8.8" PRIx32,
+				armv7m->core_cache->reg_list[i].name, armv7m->algorithm_context[i]);
+			buf_set_u32(armv7m->core_cache->reg_list[i].value,
+					0, 32, armv7m->algorithm_context[i]);
+			armv7m->core_cache->reg_list[i].valid = 1;
+			armv7m->core_cache->reg_list[i].dirty = 1;
+		}
+	}
+
+	armv7m->core_mode = armv7m->algorithm_core_mode;
+}
+
+/**
+ * Starts a Thumb algorithm in the target, without waiting for it; use
+ * armv7m_wait_algorithm() to collect its results.
+ */
+int armv7m_start_algorithm(struct target *target,
+	int num_mem_params, struct mem_param *mem_params,
+	int num_reg_params, struct reg_param *reg_params,
+	uint32_t entry_point, uint32_t exit_point,
+	void *arch_info)
+{
+	struct armv7m_common *armv7m = target_to_armv7m(target);
+	struct armv7m_algorithm *armv7m_algorithm_info = arch_info;
+	int retval = ERROR_OK;
+
+	/* NOTE: armv7m_run_algorithm requires that each algorithm uses a software breakpoint
+	 * at the exit point */
+
+	retval = armv7m_check_algorithm(target, arch_info);
+	if (retval != ERROR_OK)
+		return retval;
+
+	/* within a session, the context was saved once, up front */
+	if (!armv7m->algorithm_session)
+		armv7m_save_algorithm_context(target);
 
 	for (int i = 0; i < num_mem_params; i++)
 	{
@@ -395,8 +433,22 @@ int armv7m_run_algorithm(struct target *target,
 		armv7m->core_cache->reg_list[ARMV7M_CONTROL].valid = 1;
 	}
 
-	retval = armv7m_run_and_wait(target, entry_point, timeout_ms, exit_point, armv7m);
+	/* This code relies on the target specific  resume() and  poll()->debug_entry()
+	 * sequence to write register values to the processor and the read them back */
+	return target_resume(target, 0, entry_point, 1, 1);
+}
+
+/** Waits for an algorithm started by armv7m_start_algorithm() to finish. */
+int armv7m_wait_algorithm(struct target *target,
+	int num_mem_params, struct mem_param *mem_params,
+	int num_reg_params, struct reg_param *reg_params,
+	uint32_t exit_point, int timeout_ms,
+	void *arch_info)
+{
+	struct armv7m_common *armv7m = target_to_armv7m(target);
+	int retval;
 
+	retval = armv7m_wait_for_exit(target, timeout_ms, exit_point, armv7m);
 	if (retval != ERROR_OK)
 	{
 		return retval;
@@ -435,26 +487,67 @@ int armv7m_run_algorithm(struct target *target,
 		}
 	}
 
-	for (int i = ARMV7M_NUM_REGS - 1; i >= 0; i--)
-	{
-		uint32_t regvalue;
-		regvalue = buf_get_u32(armv7m->core_cache->reg_list[i].value, 0, 32);
-		if (regvalue != context[i])
-		{
-			LOG_DEBUG("restoring register %s with value 0x%8.8" PRIx32,
-				armv7m->core_cache->reg_list[i].name, context[i]);
-			buf_set_u32(armv7m->core_cache->reg_list[i].value,
-					0, 32, context[i]);
-			armv7m->core_cache->reg_list[i].valid = 1;
-			armv7m->core_cache->reg_list[i].dirty = 1;
-		}
-	}
-
-	armv7m->core_mode = core_mode;
+	if (!armv7m->algorithm_session)
+		armv7m_restore_algorithm_context(target);
 
 	return retval;
 }
 
+/** Runs a Thumb algorithm in the target. */
+int armv7m_run_algorithm(struct target *target,
+	int num_mem_params, struct mem_param *mem_params,
+	int num_reg_params, struct reg_param *reg_params,
+	uint32_t entry_point, uint32_t exit_point,
+	int timeout_ms, void *arch_info)
+{
+	int retval;
+
+	retval = armv7m_start_algorithm(target,
+			num_mem_params, mem_params,
+			num_reg_params, reg_params,
+			entry_point, exit_point, arch_info);
+	if (retval != ERROR_OK)
+		return retval;
+
+	return armv7m_wait_algorithm(target,
+			num_mem_params, mem_params,
+			num_reg_params, reg_params,
+			exit_point, timeout_ms, arch_info);
+}
+
+/**
+ * Saves the core state once for a series of armv7m_run_algorithm() calls,
+ * which then only load their parameters; armv7m_end_algorithm_session()
+ * restores it.
+ */
+int armv7m_begin_algorithm_session(struct target *target, void *arch_info)
+{
+	struct armv7m_common *armv7m = target_to_armv7m(target);
+	int retval;
+
+	retval = armv7m_check_algorithm(target, arch_info);
+	if (retval != ERROR_OK)
+		return retval;
+
+	armv7m_save_algorithm_context(target);
+	armv7m->algorithm_session = true;
+
+	return ERROR_OK;
+}
+
+int armv7m_end_algorithm_session(struct target *target, void *arch_info)
+{
+	struct armv7m_common *armv7m = target_to_armv7m(target);
+
+	if (!armv7m->algorithm_session)
+		return ERROR_OK;
+
+	armv7m->algorithm_session = false;
+	armv7m_restore_algorithm_context(target);
+
+	return ERROR_OK;
+}
+
 /** Logs summary of ARMv7-M state for a halted target. */
 int armv7m_arch_state(struct target *target)
 {
@@ -94,6 +94,8 @@ enum
 	ARMV7M_BASEPRI,
 	ARMV7M_FAULTMASK,
 	ARMV7M_CONTROL,
+
+	ARMV7M_LAST_REG,
 };
 
 #define ARMV7M_COMMON_MAGIC 0x2A452A45
@@ -124,6 +126,11 @@ struct armv7m_common
 	int (*post_debug_entry)(struct target *target);
 
 	void (*pre_restore_context)(struct target *target);
+
+	/* core state saved while algorithms run; see target_begin_algorithm_session() */
+	bool algorithm_session;
+	uint32_t algorithm_context[ARMV7M_LAST_REG];
+	enum armv7m_mode algorithm_core_mode;
 };
 
 static inline struct armv7m_common *
@@ -168,6 +175,20 @@ int armv7m_run_algorithm(struct target *target,
 		uint32_t entry_point, uint32_t exit_point,
 		int timeout_ms, void *arch_info);
 
+int armv7m_start_algorithm(struct target *target,
+		int num_mem_params, struct mem_param *mem_params,
+		int num_reg_params, struct reg_param *reg_params,
+		uint32_t entry_point, uint32_t exit_point,
+		void *arch_info);
+int armv7m_wait_algorithm(struct target *target,
+		int num_mem_params, struct mem_param *mem_params,
+		int num_reg_params, struct reg_param *reg_params,
+		uint32_t exit_point, int timeout_ms,
+		void *arch_info);
+
+int armv7m_begin_algorithm_session(struct target *target, void *arch_info);
+int armv7m_end_algorithm_session(struct target *target, void *arch_info);
+
 int armv7m_invalidate_core_regs(struct target *target);
 
 int armv7m_restore_context(struct target *target);
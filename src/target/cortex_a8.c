@@ -2136,6 +2136,8 @@ struct target_type cortexa8_target = {
 	.blank_check_memory = arm_blank_check_memory,
 
 	.run_algorithm = armv4_5_run_algorithm,
+	.begin_algorithm_session = armv4_5_begin_algorithm_session,
+	.end_algorithm_session = armv4_5_end_algorithm_session,
 
 	.add_breakpoint = cortex_a8_add_breakpoint,
 	.remove_breakpoint = cortex_a8_remove_breakpoint,
@@ -39,6 +39,7 @@
 #include "register.h"
 #include "arm_opcodes.h"
 #include "arm_semihosting.h"
+#include <helper/time_support.h>
 
 /* NOTE:  most of this should work fine for the Cortex-M1 and
  * Cortex-M0 cores too, although they're ARMv6-M not ARMv7-M.
@@ -417,6 +418,12 @@ static const int armv7m_msp_reg_map[17] = {
 	ARMV7M_xPSR,
 };
 
+/* registers read on every debug entry */
+static const unsigned cortex_m3_entry_regs[] = {
+	ARMV7M_R7, ARMV7M_R13, ARMV7M_R14, ARMV7M_PC,
+	ARMV7M_xPSR, ARMV7M_CONTROL,
+};
+
 static int cortex_m3_debug_entry(struct target *target)
 {
 	int i;
@@ -438,14 +445,20 @@ static int cortex_m3_debug_entry(struct target *target)
 	if ((retval = armv7m->examine_debug_reason(target)) != ERROR_OK)
 		return retval;
 
-	/* Examine target state and mode */
-	/* First load register acessible through core debug port*/
-	int num_regs = armv7m->core_cache->num_regs;
-
-	for (i = 0; i < num_regs; i++)
+	/* Examine target state and mode.  Only the registers needed for
+	 * that, and the frame registers GDB's stop reply carries, are read
+	 * now; the rest are read on demand through the register cache.
+	 */
+	for (i = 0; i < (int)ARRAY_SIZE(cortex_m3_entry_regs); i++)
 	{
-		if (!armv7m->core_cache->reg_list[i].valid)
-			armv7m->read_core_reg(target, i);
+		unsigned num = cortex_m3_entry_regs[i];
+
+		if (!armv7m->core_cache->reg_list[num].valid)
+		{
+			retval = armv7m->read_core_reg(target, num);
+			if (retval != ERROR_OK)
+				return retval;
+		}
 	}
 
 	r = armv7m->core_cache->reg_list + ARMV7M_xPSR;
@@ -1617,6 +1630,47 @@ static int cortex_m3_read_memory(struct target *target, uint32_t address,
 	return retval;
 }
 
+static int cortex_m3_access_memory_vector(struct target *target,
+		struct target_memory_item *items, unsigned count)
+{
+	struct armv7m_common *armv7m = target_to_armv7m(target);
+	struct adiv5_dap *swjdp = &armv7m->dap;
+	int retval = ERROR_OK;
+	uint32_t *data;
+	unsigned i;
+
+	data = malloc(count * sizeof(uint32_t));
+	if (data == NULL)
+		return ERROR_FAIL;
+
+	/* queue everything, then send and collect it with one flush */
+	for (i = 0; i < count && retval == ERROR_OK; i++) {
+		if (items[i].write)
+			retval = mem_ap_write_sized(swjdp, items[i].address,
+					items[i].size, items[i].value);
+		else
+			retval = mem_ap_read_sized(swjdp, items[i].address,
+					items[i].size, data + i);
+	}
+	if (retval == ERROR_OK)
+		retval = dap_run(swjdp);
+
+	if (retval == ERROR_OK) {
+		for (i = 0; i < count; i++) {
+			uint32_t value = data[i] >> (8 * (items[i].address & 3));
+
+			if (items[i].write)
+				continue;
+			if (items[i].size < 4)
+				value &= (1 << (8 * items[i].size)) - 1;
+			items[i].value = value;
+		}
+	}
+
+	free(data);
+	return retval;
+}
+
 static int cortex_m3_write_memory(struct target *target, uint32_t address,
 		uint32_t size, uint32_t count, uint8_t *buffer)
 {
@@ -1647,6 +1701,79 @@ static int cortex_m3_bulk_write_memory(struct target *target, uint32_t address,
 	return cortex_m3_write_memory(target, address, 4, count, buffer);
 }
 
+/* PCSR reads per queue flush while profiling */
+#define PCSR_BATCH	256
+
+/*
+ * Profile by sampling DWT_PCSR, which the core updates as it runs, so
+ * it never needs to be halted; each batch of samples is one flush.
+ */
+static int cortex_m3_profiling(struct target *target, uint32_t *samples,
+		uint32_t max_num_samples, uint32_t *num_samples, uint32_t seconds)
+{
+	struct armv7m_common *armv7m = target_to_armv7m(target);
+	struct adiv5_dap *swjdp = &armv7m->dap;
+	uint32_t sample_count = 0;
+	uint32_t reg_value;
+	int64_t timeout;
+	int retval;
+
+	/* ARMv6-M has no PCSR; it reads as zero */
+	retval = mem_ap_read_atomic_u32(swjdp, DWT_PCSR, &reg_value);
+	if (retval != ERROR_OK)
+		return retval;
+	if (reg_value == 0) {
+		LOG_INFO("PCSR not implemented, halting the core for each sample");
+		return target_profiling_default(target, samples,
+				max_num_samples, num_samples, seconds);
+	}
+
+	retval = target_poll(target);
+	if (retval != ERROR_OK)
+		return retval;
+	if (target->state == TARGET_HALTED) {
+		retval = target_resume(target, 1, 0, 0, 0);
+		if (retval != ERROR_OK)
+			return retval;
+	} else if (target->state != TARGET_RUNNING) {
+		LOG_INFO("Target not halted or running");
+		*num_samples = 0;
+		return ERROR_OK;
+	}
+
+	LOG_INFO("Starting profiling. Sampling DWT_PCSR as fast as we can...");
+
+	timeout = timeval_ms() + 1000 * (int64_t)seconds;
+	while (sample_count < max_num_samples) {
+		uint32_t *batch = samples + sample_count;
+		uint32_t n = max_num_samples - sample_count;
+		uint32_t i;
+
+		if (n > PCSR_BATCH)
+			n = PCSR_BATCH;
+
+		retval = mem_ap_read_buf_noincr_u32(swjdp, (uint8_t *) batch,
+				4 * n, DWT_PCSR);
+		if (retval != ERROR_OK)
+			break;
+
+		/* all ones means the core was halted or sleeping */
+		for (i = 0; i < n; i++) {
+			uint32_t pc = le_to_h_u32((uint8_t *) (batch + i));
+
+			if (pc != 0xffffffff)
+				samples[sample_count++] = pc;
+		}
+
+		keep_alive();
+		if (timeval_ms() >= timeout)
+			break;
+	}
+
+	*num_samples = sample_count;
+	return retval;
+}
+
 static int cortex_m3_init_target(struct command_context *cmd_ctx,
 		struct target *target)
 {
@@ -2223,12 +2350,19 @@ struct target_type cortexm3_target =
 	.get_gdb_reg_list = armv7m_get_gdb_reg_list,
 
 	.read_memory = cortex_m3_read_memory,
+	.read_memory_vector = cortex_m3_access_memory_vector,
+	.write_memory_vector = cortex_m3_access_memory_vector,
+	.access_memory_vector = cortex_m3_access_memory_vector,
 	.write_memory = cortex_m3_write_memory,
 	.bulk_write_memory = cortex_m3_bulk_write_memory,
 	.checksum_memory = armv7m_checksum_memory,
 	.blank_check_memory = armv7m_blank_check_memory,
 
 	.run_algorithm = armv7m_run_algorithm,
+	.start_algorithm = armv7m_start_algorithm,
+	.wait_algorithm = armv7m_wait_algorithm,
+	.begin_algorithm_session = armv7m_begin_algorithm_session,
+	.end_algorithm_session = armv7m_end_algorithm_session,
 
 	.add_breakpoint = cortex_m3_add_breakpoint,
 	.remove_breakpoint = cortex_m3_remove_breakpoint,
@@ -2239,4 +2373,5 @@ struct target_type cortexm3_target =
 	.target_create = cortex_m3_target_create,
 	.init_target = cortex_m3_init_target,
 	.examine = cortex_m3_examine,
+	.profiling = cortex_m3_profiling,
 };
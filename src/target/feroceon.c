@@ -714,6 +714,8 @@ struct target_type feroceon_target =
 	.blank_check_memory = arm_blank_check_memory,
 
 	.run_algorithm = armv4_5_run_algorithm,
+	.begin_algorithm_session = armv4_5_begin_algorithm_session,
+	.end_algorithm_session = armv4_5_end_algorithm_session,
 
 	.add_breakpoint = arm7_9_add_breakpoint,
 	.remove_breakpoint = arm7_9_remove_breakpoint,
@@ -747,12 +749,16 @@ struct target_type dragonite_target =
 
 	.read_memory = arm7_9_read_memory,
 	.write_memory = arm7_9_write_memory,
+	.read_memory_vector = arm7_9_read_memory_vector,
+	.write_memory_vector = arm7_9_write_memory_vector,
 	.bulk_write_memory = feroceon_bulk_write_memory,
 
 	.checksum_memory = arm_checksum_memory,
 	.blank_check_memory = arm_blank_check_memory,
 
 	.run_algorithm = armv4_5_run_algorithm,
+	.begin_algorithm_session = armv4_5_begin_algorithm_session,
+	.end_algorithm_session = armv4_5_end_algorithm_session,
 
 	.add_breakpoint = arm7_9_add_breakpoint,
 	.remove_breakpoint = arm7_9_remove_breakpoint,
@@ -147,245 +147,411 @@ static int identify_image_type(struct image *image, const char *type_string, con
 	return ERROR_OK;
 }
 
-static int image_ihex_buffer_complete_inner(struct image *image, char *lpszLine, struct imagesection *section)
+/* hex digit values, tagged with 0x10 so that zero means "not a digit" */
+static const uint8_t image_hex_digits[256] = {
+	['0'] = 0x10, ['1'] = 0x11, ['2'] = 0x12, ['3'] = 0x13,
+	['4'] = 0x14, ['5'] = 0x15, ['6'] = 0x16, ['7'] = 0x17,
+	['8'] = 0x18, ['9'] = 0x19,
+	['A'] = 0x1a, ['B'] = 0x1b, ['C'] = 0x1c, ['D'] = 0x1d, ['E'] = 0x1e, ['F'] = 0x1f,
+	['a'] = 0x1a, ['b'] = 0x1b, ['c'] = 0x1c, ['d'] = 0x1d, ['e'] = 0x1e, ['f'] = 0x1f,
+};
+
+/* count, address, type, 255 data bytes and checksum of the longest IHEX record */
+#define IMAGE_RECORD_MAX	260
+
+/* state of a pass over a hex or S-record file */
+struct image_text
 {
-	struct image_ihex *ihex = image->type_private;
-	struct fileio *fileio = &ihex->fileio;
-	uint32_t full_address = 0x0;
+	const char *text, *end;
+	int line;
+	/* where the data and sections go, or NULL while counting them */
+	uint8_t *buffer;
+	struct imagesection *sections;
 	uint32_t cooked_bytes;
-	int i;
+	int num_sections;			/* index of the current section */
+	uint32_t section_size;		/* of the current section */
+};
+
+/**
+ * Return the next non-empty line of a text image, without its line end,
+ * or NULL at the end of the file.
+ */
+static const char *image_text_line(struct image_text *t, const char **eol)
+{
+	while (t->text < t->end)
+	{
+		const char *line = t->text;
+		const char *p = memchr(line, '\n', t->end - line);
+
+		if (p == NULL)
+			p = t->end;
+		t->text = p + 1;
+		t->line++;
+
+		/* also drops DOS line ends */
+		while ((p > line) && isspace((unsigned char)p[-1]))
+			p--;
+		if (p > line)
+		{
+			*eol = p;
+			return line;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Decode the hex digits from @a p up to @a eol into @a record, returning
+ * the number of bytes or -1 if there's anything else on the line.
+ */
+static int image_decode_record(const char *p, const char *eol, uint8_t *record)
+{
+	int n = 0;
+
+	if (((eol - p) & 1) || ((eol - p) / 2 > IMAGE_RECORD_MAX))
+		return -1;
+
+	for (; p < eol; p += 2)
+	{
+		uint8_t hi = image_hex_digits[(uint8_t)p[0]];
+		uint8_t lo = image_hex_digits[(uint8_t)p[1]];
 
-	/* we can't determine the number of sections that we'll have to create ahead of time,
-	 * so we locally hold them until parsing is finished */
+		if (!(hi & lo & 0x10))
+			return -1;
+		record[n++] = (uint8_t)((hi << 4) | (lo & 0x0f));
+	}
+
+	return n;
+}
+
+static uint8_t image_record_sum(const uint8_t *record, int n)
+{
+	uint8_t sum = 0;
+
+	while (n-- > 0)
+		sum += *record++;
+
+	return sum;
+}
+
+/* start a section at @a base, unless the current one is still empty,
+ * in which case this just moves it */
+static void image_text_section(struct image_text *t, uint32_t base)
+{
+	struct imagesection *section;
+
+	if (t->section_size != 0)
+	{
+		t->num_sections++;
+		t->section_size = 0;
+	}
+
+	if (!t->sections)
+		return;
+
+	section = &t->sections[t->num_sections];
+	section->base_address = base;
+	section->size = 0;
+	section->flags = 0;
+	section->private = t->buffer + t->cooked_bytes;
+}
+
+static void image_text_data(struct image_text *t, const uint8_t *data, unsigned count)
+{
+	if (t->buffer)
+	{
+		memcpy(t->buffer + t->cooked_bytes, data, count);
+		t->sections[t->num_sections].size += count;
+	}
+	t->cooked_bytes += count;
+	t->section_size += count;
+}
 
+/**
+ * Get the whole text of a hex or S-record file in memory, mapped where
+ * possible; otherwise read into @a buffer, which the caller must free().
+ */
+static int image_text_load(struct fileio *fileio, struct image_text *t, uint8_t **buffer)
+{
+	uint8_t *text;
 	int filesize;
+	size_t size_read;
 	int retval;
+
+	*buffer = NULL;
+
 	retval = fileio_size(fileio, &filesize);
 	if (retval != ERROR_OK)
 		return retval;
 
-	ihex->buffer = malloc(filesize >> 1);
-	cooked_bytes = 0x0;
-	image->num_sections = 0;
-	section[image->num_sections].private = &ihex->buffer[cooked_bytes];
-	section[image->num_sections].base_address = 0x0;
-	section[image->num_sections].size = 0x0;
-	section[image->num_sections].flags = 0;
+	if (fileio_map(fileio, &text) != ERROR_OK)
+	{
+		*buffer = text = malloc(filesize + 1);
+		if (text == NULL)
+		{
+			LOG_ERROR("Out of memory");
+			return ERROR_FAIL;
+		}
+		retval = fileio_read(fileio, filesize, text, &size_read);
+		if (retval != ERROR_OK)
+		{
+			free(text);
+			*buffer = NULL;
+			return retval;
+		}
+		/* text mode reads may come up short on DOS line ends */
+		filesize = size_read;
+	}
+
+	t->text = (const char *)text;
+	t->end = t->text + filesize;
+	return ERROR_OK;
+}
+
+/**
+ * Parse an IHEX file, with @a t set up for either the counting pass
+ * or the one which fills in the sections.
+ */
+static int image_ihex_parse(struct image *image, struct image_text *t)
+{
+	uint32_t full_address = 0x0;
+	uint8_t record[IMAGE_RECORD_MAX];
+	const char *line, *eol;
+
+	image_text_section(t, 0x0);
 
-	while (fileio_fgets(fileio, 1023, lpszLine) == ERROR_OK)
+	while ((line = image_text_line(t, &eol)) != NULL)
 	{
-		uint32_t count;
-		uint32_t address;
-		uint32_t record_type;
-		uint32_t checksum;
-		uint8_t cal_checksum = 0;
-		size_t bytes_read = 0;
+		int n;
+		uint32_t count, address, record_type;
 
-		if (sscanf(&lpszLine[bytes_read], ":%2" SCNx32 "%4" SCNx32 "%2" SCNx32 , &count, &address, &record_type) != 3)
+		n = (line[0] == ':') ? image_decode_record(line + 1, eol, record) : -1;
+		if ((n < 5) || (n != record[0] + 5))
 		{
+			LOG_ERROR("malformed record in IHEX file, line %d", t->line);
 			return ERROR_IMAGE_FORMAT_ERROR;
 		}
-		bytes_read += 9;
 
-		cal_checksum += (uint8_t)count;
-		cal_checksum += (uint8_t)(address >> 8);
-		cal_checksum += (uint8_t)address;
-		cal_checksum += (uint8_t)record_type;
+		if (image_record_sum(record, n) != 0)
+		{
+			/* checksum failed */
+			LOG_ERROR("incorrect record checksum found in IHEX file, line %d", t->line);
+			return ERROR_IMAGE_CHECKSUM;
+		}
+
+		count = record[0];
+		address = be_to_h_u16(record + 1);
+		record_type = record[3];
 
 		if (record_type == 0) /* Data Record */
 		{
 			if ((full_address & 0xffff) != address)
 			{
-				/* we encountered a nonconsecutive location, create a new section,
-				 * unless the current section has zero size, in which case this specifies
-				 * the current section's base address
-				 */
-				if (section[image->num_sections].size != 0)
-				{
-					image->num_sections++;
-					if (image->num_sections >= IMAGE_MAX_SECTIONS)
-					{
-						/* too many sections */
-						LOG_ERROR("Too many sections found in IHEX file");
-						return ERROR_IMAGE_FORMAT_ERROR;
-					}
-					section[image->num_sections].size = 0x0;
-					section[image->num_sections].flags = 0;
-					section[image->num_sections].private = &ihex->buffer[cooked_bytes];
-				}
-				section[image->num_sections].base_address =
-					(full_address & 0xffff0000) | address;
+				/* we encountered a nonconsecutive location */
 				full_address = (full_address & 0xffff0000) | address;
+				image_text_section(t, full_address);
 			}
 
-			while (count-- > 0)
-			{
-				unsigned value;
-				sscanf(&lpszLine[bytes_read], "%2x", &value);
-				ihex->buffer[cooked_bytes] = (uint8_t)value;
-				cal_checksum += (uint8_t)ihex->buffer[cooked_bytes];
-				bytes_read += 2;
-				cooked_bytes += 1;
-				section[image->num_sections].size += 1;
-				full_address++;
-			}
+			image_text_data(t, record + 4, count);
+			full_address += count;
 		}
 		else if (record_type == 1) /* End of File Record */
 		{
 			/* finish the current section */
-			image->num_sections++;
-
-			/* copy section information */
-			image->sections = malloc(sizeof(struct imagesection) * image->num_sections);
-			for (i = 0; i < image->num_sections; i++)
-			{
-				image->sections[i].private = section[i].private;
-				image->sections[i].base_address = section[i].base_address;
-				image->sections[i].size = section[i].size;
-				image->sections[i].flags = section[i].flags;
-			}
-
+			t->num_sections++;
 			return ERROR_OK;
 		}
-		else if (record_type == 2) /* Linear Address Record */
+		else if ((record_type == 2) || (record_type == 4))
 		{
-			uint16_t upper_address;
+			/* Linear Address Record, Extended Linear Address Record */
+			unsigned shift = (record_type == 2) ? 4 : 16;
+			uint32_t upper_address;
 
-			sscanf(&lpszLine[bytes_read], "%4hx", &upper_address);
-			cal_checksum += (uint8_t)(upper_address >> 8);
-			cal_checksum += (uint8_t)upper_address;
-			bytes_read += 4;
+			if (count != 2)
+			{
+				LOG_ERROR("malformed record in IHEX file, line %d", t->line);
+				return ERROR_IMAGE_FORMAT_ERROR;
+			}
+			upper_address = be_to_h_u16(record + 4);
 
-			if ((full_address >> 4) != upper_address)
+			if ((full_address >> shift) != upper_address)
 			{
-				/* we encountered a nonconsecutive location, create a new section,
-				 * unless the current section has zero size, in which case this specifies
-				 * the current section's base address
-				 */
-				if (section[image->num_sections].size != 0)
-				{
-					image->num_sections++;
-					if (image->num_sections >= IMAGE_MAX_SECTIONS)
-					{
-						/* too many sections */
-						LOG_ERROR("Too many sections found in IHEX file");
-						return ERROR_IMAGE_FORMAT_ERROR;
-					}
-					section[image->num_sections].size = 0x0;
-					section[image->num_sections].flags = 0;
-					section[image->num_sections].private = &ihex->buffer[cooked_bytes];
-				}
-				section[image->num_sections].base_address =
-					(full_address & 0xffff) | (upper_address << 4);
-				full_address = (full_address & 0xffff) | (upper_address << 4);
+				/* we encountered a nonconsecutive location */
+				full_address = (full_address & 0xffff) | (upper_address << shift);
+				image_text_section(t, full_address);
 			}
 		}
 		else if (record_type == 3) /* Start Segment Address Record */
 		{
-			uint32_t dummy;
-
 			/* "Start Segment Address Record" will not be supported */
 			/* but we must consume it, and do not create an error.  */
-			while (count-- > 0)
-			{
-				sscanf(&lpszLine[bytes_read], "%2" SCNx32 , &dummy);
-				cal_checksum += (uint8_t)dummy;
-				bytes_read += 2;
-			}
 		}
-		else if (record_type == 4) /* Extended Linear Address Record */
+		else if (record_type == 5) /* Start Linear Address Record */
 		{
-			uint16_t upper_address;
-
-			sscanf(&lpszLine[bytes_read], "%4hx", &upper_address);
-			cal_checksum += (uint8_t)(upper_address >> 8);
-			cal_checksum += (uint8_t)upper_address;
-			bytes_read += 4;
-
-			if ((full_address >> 16) != upper_address)
+			if (count != 4)
 			{
-				/* we encountered a nonconsecutive location, create a new section,
-				 * unless the current section has zero size, in which case this specifies
-				 * the current section's base address
-				 */
-				if (section[image->num_sections].size != 0)
-				{
-					image->num_sections++;
-					if (image->num_sections >= IMAGE_MAX_SECTIONS)
-					{
-						/* too many sections */
-						LOG_ERROR("Too many sections found in IHEX file");
-						return ERROR_IMAGE_FORMAT_ERROR;
-					}
-					section[image->num_sections].size = 0x0;
-					section[image->num_sections].flags = 0;
-					section[image->num_sections].private = &ihex->buffer[cooked_bytes];
-				}
-				section[image->num_sections].base_address =
-					(full_address & 0xffff) | (upper_address << 16);
-				full_address = (full_address & 0xffff) | (upper_address << 16);
+				LOG_ERROR("malformed record in IHEX file, line %d", t->line);
+				return ERROR_IMAGE_FORMAT_ERROR;
 			}
-		}
-		else if (record_type == 5) /* Start Linear Address Record */
-		{
-			uint32_t start_address;
-
-			sscanf(&lpszLine[bytes_read], "%8" SCNx32, &start_address);
-			cal_checksum += (uint8_t)(start_address >> 24);
-			cal_checksum += (uint8_t)(start_address >> 16);
-			cal_checksum += (uint8_t)(start_address >> 8);
-			cal_checksum += (uint8_t)start_address;
-			bytes_read += 8;
 
 			image->start_address_set = 1;
-			image->start_address = be_to_h_u32((uint8_t*)&start_address);
+			image->start_address = be_to_h_u32(record + 4);
 		}
 		else
 		{
-		  LOG_ERROR("unhandled IHEX record type: %i", (int)record_type);
+			LOG_ERROR("unhandled IHEX record type: %i", (int)record_type);
 			return ERROR_IMAGE_FORMAT_ERROR;
 		}
+	}
+
+	LOG_ERROR("premature end of IHEX file, no end-of-file record found");
+	return ERROR_IMAGE_FORMAT_ERROR;
+}
+
+/**
+ * Parse an S-record file, like image_ihex_parse().
+ */
+static int image_mot_parse(struct image *image, struct image_text *t)
+{
+	uint32_t full_address = 0x0;
+	uint8_t record[IMAGE_RECORD_MAX];
+	const char *line, *eol;
+
+	image_text_section(t, 0x0);
 
-		sscanf(&lpszLine[bytes_read], "%2" SCNx32 , &checksum);
-		bytes_read += 2;
+	while ((line = image_text_line(t, &eol)) != NULL)
+	{
+		int n = -1;
+		uint32_t count, address, record_type = 0;
 
-		if ((uint8_t)checksum != (uint8_t)(~cal_checksum + 1))
+		/* record type and length, then address, data and checksum */
+		if ((line[0] == 'S') && (eol - line >= 2) && isdigit((unsigned char)line[1]))
+		{
+			record_type = line[1] - '0';
+			n = image_decode_record(line + 2, eol, record);
+		}
+		if ((n < 2) || (n != record[0] + 1))
+		{
+			LOG_ERROR("malformed record in S19 file, line %d", t->line);
+			return ERROR_IMAGE_FORMAT_ERROR;
+		}
+
+		if (image_record_sum(record, n) != 0xff)
 		{
 			/* checksum failed */
-			LOG_ERROR("incorrect record checksum found in IHEX file");
+			LOG_ERROR("incorrect record checksum found in S19 file, line %d", t->line);
 			return ERROR_IMAGE_CHECKSUM;
 		}
+
+		/* skip the length and checksum bytes */
+		count = record[0] - 1;
+
+		if ((record_type == 0) || (record_type == 5))
+		{
+			/* S0 - starting record (optional) */
+			/* S5 is the data count record, we ignore it */
+		}
+		else if (record_type >= 1 && record_type <= 3)
+		{
+			/* S1, S2, S3 - 16, 24 and 32 bit address data records */
+			unsigned address_bytes = record_type + 1;
+			unsigned i;
+
+			if (count < address_bytes)
+			{
+				LOG_ERROR("malformed record in S19 file, line %d", t->line);
+				return ERROR_IMAGE_FORMAT_ERROR;
+			}
+
+			address = 0;
+			for (i = 0; i < address_bytes; i++)
+				address = (address << 8) | record[1 + i];
+			count -= address_bytes;
+
+			if (full_address != address)
+			{
+				/* we encountered a nonconsecutive location */
+				full_address = address;
+				image_text_section(t, full_address);
+			}
+
+			image_text_data(t, record + 1 + address_bytes, count);
+			full_address += count;
+		}
+		else if (record_type >= 7 && record_type <= 9)
+		{
+			/* S7, S8, S9 - ending records for 32, 24 and 16bit */
+			t->num_sections++;
+			return ERROR_OK;
+		}
+		else
+		{
+			LOG_ERROR("unhandled S19 record type: %i", (int)(record_type));
+			return ERROR_IMAGE_FORMAT_ERROR;
+		}
 	}
 
-	LOG_ERROR("premature end of IHEX file, no end-of-file record found");
+	LOG_ERROR("premature end of S19 file, no end-of-file record found");
 	return ERROR_IMAGE_FORMAT_ERROR;
 }
 
 /**
- * Allocate memory dynamically instead of on the stack. This
- * is important w/embedded hosts.
+ * Parse a hex or S-record file in two passes: the first checks it and
+ * counts the sections and data, so that the second can decode straight
+ * into buffers of the right size.
  */
-static int image_ihex_buffer_complete(struct image *image)
+static int image_text_buffer_complete(struct image *image, struct fileio *fileio,
+		uint8_t **data, int (*parse)(struct image *image, struct image_text *t))
 {
-	char *lpszLine = malloc(1023);
-	if (lpszLine == NULL)
-	{
-		LOG_ERROR("Out of memory");
-		return ERROR_FAIL;
-	}
-	struct imagesection *section = malloc(sizeof(struct imagesection) * IMAGE_MAX_SECTIONS);
-	if (section == NULL)
+	struct image_text t;
+	const char *text, *end;
+	uint8_t *buffer;
+	int retval;
+
+	*data = NULL;
+	image->sections = NULL;
+	image->num_sections = 0;
+
+	memset(&t, 0, sizeof(t));
+	retval = image_text_load(fileio, &t, &buffer);
+	if (retval != ERROR_OK)
+		return retval;
+	text = t.text;
+	end = t.end;
+
+	retval = parse(image, &t);
+	if (retval != ERROR_OK)
+		goto done;
+
+	*data = malloc(t.cooked_bytes ? t.cooked_bytes : 1);
+	image->sections = malloc(sizeof(struct imagesection) * t.num_sections);
+	if ((*data == NULL) || (image->sections == NULL))
 	{
-		free(lpszLine);
 		LOG_ERROR("Out of memory");
-		return ERROR_FAIL;
+		retval = ERROR_FAIL;
+		goto done;
 	}
-	int retval;
 
-	retval = image_ihex_buffer_complete_inner(image, lpszLine, section);
+	memset(&t, 0, sizeof(t));
+	t.text = text;
+	t.end = end;
+	t.buffer = *data;
+	t.sections = image->sections;
 
-	free(section);
-	free(lpszLine);
+	retval = parse(image, &t);
+	if (retval == ERROR_OK)
+		image->num_sections = t.num_sections;
+
+done:
+	if (retval != ERROR_OK)
+	{
+		free(*data);
+		*data = NULL;
+		free(image->sections);
+		image->sections = NULL;
+	}
+	free(buffer);
 
 	return retval;
 }
@@ -532,210 +698,6 @@ static int image_elf_read_section(struct image *image, int section, uint32_t off
 	return ERROR_OK;
 }
 
-static int image_mot_buffer_complete_inner(struct image *image, char *lpszLine, struct imagesection *section)
-{
-	struct image_mot *mot = image->type_private;
-	struct fileio *fileio = &mot->fileio;
-	uint32_t full_address = 0x0;
-	uint32_t cooked_bytes;
-	int i;
-
-	/* we can't determine the number of sections that we'll have to create ahead of time,
-	 * so we locally hold them until parsing is finished */
-
-	int retval;
-	int filesize;
-	retval = fileio_size(fileio, &filesize);
-	if (retval != ERROR_OK)
-		return retval;
-
-	mot->buffer = malloc(filesize >> 1);
-	cooked_bytes = 0x0;
-	image->num_sections = 0;
-	section[image->num_sections].private = &mot->buffer[cooked_bytes];
-	section[image->num_sections].base_address = 0x0;
-	section[image->num_sections].size = 0x0;
-	section[image->num_sections].flags = 0;
-
-	while (fileio_fgets(fileio, 1023, lpszLine) == ERROR_OK)
-	{
-		uint32_t count;
-		uint32_t address;
-		uint32_t record_type;
-		uint32_t checksum;
-		uint8_t cal_checksum = 0;
-		uint32_t bytes_read = 0;
-
-		/* get record type and record length */
-		if (sscanf(&lpszLine[bytes_read], "S%1" SCNx32 "%2" SCNx32 , &record_type, &count) != 2)
-		{
-			return ERROR_IMAGE_FORMAT_ERROR;
-		}
-
-		bytes_read += 4;
-		cal_checksum += (uint8_t)count;
-
-		/* skip checksum byte */
-		count -=1;
-
-		if (record_type == 0)
-		{
-			/* S0 - starting record (optional) */
-			int iValue;
-
-			while (count-- > 0) {
-				sscanf(&lpszLine[bytes_read], "%2x", &iValue);
-				cal_checksum += (uint8_t)iValue;
-				bytes_read += 2;
-			}
-		}
-		else if (record_type >= 1 && record_type <= 3)
-		{
-			switch (record_type)
-			{
-				case 1:
-					/* S1 - 16 bit address data record */
-					sscanf(&lpszLine[bytes_read], "%4" SCNx32, &address);
-					cal_checksum += (uint8_t)(address >> 8);
-					cal_checksum += (uint8_t)address;
-					bytes_read += 4;
-					count -=2;
-					break;
-
-				case 2:
-					/* S2 - 24 bit address data record */
-					sscanf(&lpszLine[bytes_read], "%6" SCNx32 , &address);
-					cal_checksum += (uint8_t)(address >> 16);
-					cal_checksum += (uint8_t)(address >> 8);
-					cal_checksum += (uint8_t)address;
-					bytes_read += 6;
-					count -=3;
-					break;
-
-				case 3:
-					/* S3 - 32 bit address data record */
-					sscanf(&lpszLine[bytes_read], "%8" SCNx32 , &address);
-					cal_checksum += (uint8_t)(address >> 24);
-					cal_checksum += (uint8_t)(address >> 16);
-					cal_checksum += (uint8_t)(address >> 8);
-					cal_checksum += (uint8_t)address;
-					bytes_read += 8;
-					count -=4;
-					break;
-
-			}
-
-			if (full_address != address)
-			{
-				/* we encountered a nonconsecutive location, create a new section,
-				 * unless the current section has zero size, in which case this specifies
-				 * the current section's base address
-				 */
-				if (section[image->num_sections].size != 0)
-				{
-					image->num_sections++;
-					section[image->num_sections].size = 0x0;
-					section[image->num_sections].flags = 0;
-					section[image->num_sections].private = &mot->buffer[cooked_bytes];
-				}
-				section[image->num_sections].base_address = address;
-				full_address = address;
-			}
-
-			while (count-- > 0)
-			{
-				unsigned value;
-				sscanf(&lpszLine[bytes_read], "%2x", &value);
-				mot->buffer[cooked_bytes] = (uint8_t)value;
-				cal_checksum += (uint8_t)mot->buffer[cooked_bytes];
-				bytes_read += 2;
-				cooked_bytes += 1;
-				section[image->num_sections].size += 1;
-				full_address++;
-			}
-		}
-		else if (record_type == 5)
-		{
-			/* S5 is the data count record, we ignore it */
-			uint32_t dummy;
-
-			while (count-- > 0)
-			{
-				sscanf(&lpszLine[bytes_read], "%2" SCNx32 , &dummy);
-				cal_checksum += (uint8_t)dummy;
-				bytes_read += 2;
-			}
-		}
-		else if (record_type >= 7 && record_type <= 9)
-		{
-			/* S7, S8, S9 - ending records for 32, 24 and 16bit */
-			image->num_sections++;
-
-			/* copy section information */
-			image->sections = malloc(sizeof(struct imagesection) * image->num_sections);
-			for (i = 0; i < image->num_sections; i++)
-			{
-				image->sections[i].private = section[i].private;
-				image->sections[i].base_address = section[i].base_address;
-				image->sections[i].size = section[i].size;
-				image->sections[i].flags = section[i].flags;
-			}
-
-			return ERROR_OK;
-		}
-		else
-		{
-		  LOG_ERROR("unhandled S19 record type: %i", (int)(record_type));
-			return ERROR_IMAGE_FORMAT_ERROR;
-		}
-
-		/* account for checksum, will always be 0xFF */
-		sscanf(&lpszLine[bytes_read], "%2" SCNx32 , &checksum);
-		cal_checksum += (uint8_t)checksum;
-		bytes_read += 2;
-
-		if (cal_checksum != 0xFF)
-		{
-			/* checksum failed */
-			LOG_ERROR("incorrect record checksum found in S19 file");
-			return ERROR_IMAGE_CHECKSUM;
-		}
-	}
-
-	LOG_ERROR("premature end of S19 file, no end-of-file record found");
-	return ERROR_IMAGE_FORMAT_ERROR;
-}
-
-/**
- * Allocate memory dynamically instead of on the stack. This
- * is important w/embedded hosts.
- */
-static int image_mot_buffer_complete(struct image *image)
-{
-	char *lpszLine = malloc(1023);
-	if (lpszLine == NULL)
-	{
-		LOG_ERROR("Out of memory");
-		return ERROR_FAIL;
-	}
-	struct imagesection *section = malloc(sizeof(struct imagesection) * IMAGE_MAX_SECTIONS);
-	if (section == NULL)
-	{
-		free(lpszLine);
-		LOG_ERROR("Out of memory");
-		return ERROR_FAIL;
-	}
-	int retval;
-
-	retval = image_mot_buffer_complete_inner(image, lpszLine, section);
-
-	free(section);
-	free(lpszLine);
-
-	return retval;
-}
-
-
 int image_open(struct image *image, const char *url, const char *type_string)
 {
 	int retval = ERROR_OK;
@@ -780,7 +742,8 @@ int image_open(struct image *image, const char *url, const char *type_string)
 			return retval;
 		}
 
-		if ((retval = image_ihex_buffer_complete(image)) != ERROR_OK)
+		if ((retval = image_text_buffer_complete(image,
+				&image_ihex->fileio, &image_ihex->buffer, image_ihex_parse)) != ERROR_OK)
 		{
 			LOG_ERROR("failed buffering IHEX image, check daemon output for additional information");
 			fileio_close(&image_ihex->fileio);
@@ -839,7 +802,8 @@ int image_open(struct image *image, const char *url, const char *type_string)
 			return retval;
 		}
 
-		if ((retval = image_mot_buffer_complete(image)) != ERROR_OK)
+		if ((retval = image_text_buffer_complete(image,
+				&image_mot->fileio, &image_mot->buffer, image_mot_parse)) != ERROR_OK)
 		{
 			LOG_ERROR("failed buffering S19 image, check daemon output for additional information");
 			fileio_close(&image_mot->fileio);
@@ -971,6 +935,106 @@ int image_read_section(struct image *image, int section, uint32_t offset, uint32
 	return ERROR_OK;
 }
 
+/* point at section contents the image already holds in memory */
+static int image_map_section(struct image *image, int section, uint32_t offset, uint8_t **data)
+{
+	uint8_t *map;
+	int retval;
+
+	if (image->type == IMAGE_BINARY)
+	{
+		struct image_binary *image_binary = image->type_private;
+
+		/* only one section in a plain binary */
+		if (section != 0)
+			return ERROR_INVALID_ARGUMENTS;
+
+		if ((retval = fileio_map(&image_binary->fileio, &map)) != ERROR_OK)
+			return retval;
+
+		*data = map + offset;
+	}
+	else if (image->type == IMAGE_ELF)
+	{
+		struct image_elf *elf = image->type_private;
+		Elf32_Phdr *segment = (Elf32_Phdr *)image->sections[section].private;
+		int filesize;
+
+		if ((retval = fileio_map(&elf->fileio, &map)) != ERROR_OK)
+			return retval;
+
+		/* let a truncated file fail the way reading it would */
+		fileio_size(&elf->fileio, &filesize);
+		if (field32(elf, segment->p_offset) + field32(elf, segment->p_filesz) > (uint32_t)filesize)
+			return ERROR_FILEIO_OPERATION_NOT_SUPPORTED;
+
+		*data = map + field32(elf, segment->p_offset) + offset;
+	}
+	else if ((image->type == IMAGE_IHEX)
+			|| (image->type == IMAGE_SRECORD)
+			|| (image->type == IMAGE_BUILDER))
+	{
+		*data = (uint8_t*)image->sections[section].private + offset;
+	}
+	else
+	{
+		return ERROR_FILEIO_OPERATION_NOT_SUPPORTED;
+	}
+
+	return ERROR_OK;
+}
+
+/**
+ * Get @a size bytes of a section, like image_read_section(), but without
+ * copying them when the image already holds them in memory: binary and
+ * ELF files are mapped, and hex, S-record and built images are parsed
+ * into memory when they're opened.  Otherwise the data is read into a
+ * buffer allocated here and returned in @a buffer, which the caller must
+ * free(); @a buffer is NULL when @a data points into the image.
+ *
+ * The data must be treated as read-only, and is valid until the image
+ * is closed.
+ */
+int image_get_section(struct image *image, int section, uint32_t offset,
+		uint32_t size, uint8_t **data, uint8_t **buffer, size_t *size_read)
+{
+	int retval;
+
+	*buffer = NULL;
+
+	/* don't read past the end of a section */
+	if (offset + size > image->sections[section].size)
+	{
+		LOG_DEBUG("read past end of section: 0x%8.8" PRIx32 " + 0x%8.8" PRIx32 " > 0x%8.8" PRIx32 "",
+				offset, size, image->sections[section].size);
+		return ERROR_INVALID_ARGUMENTS;
+	}
+
+	if (image_map_section(image, section, offset, data) == ERROR_OK)
+	{
+		*size_read = size;
+		return ERROR_OK;
+	}
+
+	*buffer = malloc(size);
+	if (*buffer == NULL)
+	{
+		LOG_ERROR("error allocating buffer for section (%" PRIu32 " bytes)", size);
+		return ERROR_FAIL;
+	}
+
+	retval = image_read_section(image, section, offset, size, *buffer, size_read);
+	if (retval != ERROR_OK)
+	{
+		free(*buffer);
+		*buffer = NULL;
+		return retval;
+	}
+
+	*data = *buffer;
+	return ERROR_OK;
+}
+
 int image_add_section(struct image *image, uint32_t base, uint32_t size, int flags, uint8_t *data)
 {
 	struct imagesection *section;
@@ -1092,43 +1156,85 @@ void image_close(struct image *image)
 	}
 }
 
-int image_calculate_checksum(uint8_t* buffer, uint32_t nbytes, uint32_t* checksum)
+/* crc32_table[k][i] is the CRC of byte i followed by k zero bytes */
+static uint32_t crc32_table[8][256];
+
+static void image_crc32_init(void)
 {
-	uint32_t crc = 0xffffffff;
-	LOG_DEBUG("Calculating checksum");
+	int i, j, k;
+	unsigned int c;
 
-	static uint32_t crc32_table[256];
+	for (i = 0; i < 256; i++)
+	{
+		/* as per gdb */
+		for (c = i << 24, j = 8; j > 0; --j)
+			c = c & 0x80000000 ? (c << 1) ^ 0x04c11db7 : (c << 1);
+		crc32_table[0][i] = c;
+	}
 
-	static bool first_init = false;
-	if (!first_init)
+	for (k = 1; k < 8; k++)
 	{
-		/* Initialize the CRC table and the decoding table.  */
-		int i, j;
-		unsigned int c;
 		for (i = 0; i < 256; i++)
 		{
-			/* as per gdb */
-			for (c = i << 24, j = 8; j > 0; --j)
-				c = c & 0x80000000 ? (c << 1) ^ 0x04c11db7 : (c << 1);
-			crc32_table[i] = c;
+			c = crc32_table[k - 1][i];
+			crc32_table[k][i] = (c << 8) ^ crc32_table[0][c >> 24];
 		}
+	}
+}
+
+/* "slice by 8": eight table lookups per eight bytes, with no dependency
+ * between them, rather than one dependent lookup per byte */
+static uint32_t image_crc32(uint32_t crc, const uint8_t *buffer, uint32_t nbytes)
+{
+	while (nbytes >= 8)
+	{
+		uint32_t one = crc ^ be_to_h_u32(buffer);
+		uint32_t two = be_to_h_u32(buffer + 4);
+
+		crc = crc32_table[7][one >> 24]
+			^ crc32_table[6][(one >> 16) & 255]
+			^ crc32_table[5][(one >> 8) & 255]
+			^ crc32_table[4][one & 255]
+			^ crc32_table[3][two >> 24]
+			^ crc32_table[2][(two >> 16) & 255]
+			^ crc32_table[1][(two >> 8) & 255]
+			^ crc32_table[0][two & 255];
+
+		buffer += 8;
+		nbytes -= 8;
+	}
+
+	while (nbytes--)
+	{
+		/* as per gdb */
+		crc = (crc << 8) ^ crc32_table[0][((crc >> 24) ^ *buffer++) & 255];
+	}
+
+	return crc;
+}
 
+int image_calculate_checksum(uint8_t* buffer, uint32_t nbytes, uint32_t* checksum)
+{
+	uint32_t crc = 0xffffffff;
+	LOG_DEBUG("Calculating checksum");
+
+	static bool first_init = false;
+	if (!first_init)
+	{
+		image_crc32_init();
 		first_init = true;
 	}
 
 	while (nbytes > 0)
 	{
-		int run = nbytes;
-		if (run > 32768)
+		uint32_t run = nbytes;
+		if (run > 1024 * 1024)
 		{
-			run = 32768;
+			run = 1024 * 1024;
 		}
+		crc = image_crc32(crc, buffer, run);
+		buffer += run;
 		nbytes -= run;
-		while (run--)
-		{
-			/* as per gdb */
-			crc = (crc << 8) ^ crc32_table[((crc >> 24) ^ *buffer++) & 255];
-		}
 		keep_alive();
 	}
 
@@ -0,0 +1,292 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mem_cache.h"
+#include "target.h"
+#include "target_type.h"
+#include <helper/log.h>
+#include <helper/perf.h>
+
+#define MEM_CACHE_LINES			256
+#define MEM_CACHE_DEFAULT_LINE	64
+
+static struct mem_cache *mem_cache_get(struct target *target)
+{
+	struct mem_cache *cache = target->mem_cache;
+
+	if (cache)
+		return cache;
+
+	cache = calloc(1, sizeof(*cache));
+	if (cache)
+		cache->line_size = MEM_CACHE_DEFAULT_LINE;
+	target->mem_cache = cache;
+	return cache;
+}
+
+static void mem_cache_free_lines(struct mem_cache *cache)
+{
+	free(cache->lines);
+	cache->lines = NULL;
+	free(cache->data);
+	cache->data = NULL;
+}
+
+int target_mem_cache_set_line_size(struct target *target, uint32_t line_size)
+{
+	struct mem_cache *cache = mem_cache_get(target);
+
+	if (!cache)
+		return ERROR_FAIL;
+
+	if (line_size < 4 || line_size > 4096 || (line_size & (line_size - 1)))
+	{
+		LOG_ERROR("cache line size must be a power of two from 4 to 4096");
+		return ERROR_INVALID_ARGUMENTS;
+	}
+	if (cache->regions && line_size != cache->line_size)
+	{
+		LOG_ERROR("clear the cacheable regions before changing the line size");
+		return ERROR_FAIL;
+	}
+
+	cache->line_size = line_size;
+	return ERROR_OK;
+}
+
+int target_mem_cache_add_region(struct target *target,
+		uint32_t address, uint32_t size)
+{
+	struct mem_cache *cache = mem_cache_get(target);
+	struct mem_cache_region *region;
+
+	if (!cache)
+		return ERROR_FAIL;
+
+	if (size == 0 || ((address | size) & (cache->line_size - 1))
+			|| address + size - 1 < address)
+	{
+		LOG_ERROR("cacheable region must be non-empty, not wrap, and be "
+				"aligned to the %" PRIu32 " byte line size",
+				cache->line_size);
+		return ERROR_INVALID_ARGUMENTS;
+	}
+
+	if (!cache->lines)
+	{
+		cache->lines = calloc(MEM_CACHE_LINES, sizeof(*cache->lines));
+		cache->data = malloc(MEM_CACHE_LINES * cache->line_size);
+		if (!cache->lines || !cache->data)
+		{
+			mem_cache_free_lines(cache);
+			LOG_ERROR("out of memory");
+			return ERROR_FAIL;
+		}
+	}
+
+	region = malloc(sizeof(*region));
+	if (!region)
+		return ERROR_FAIL;
+	region->address = address;
+	region->size = size;
+	region->next = cache->regions;
+	cache->regions = region;
+
+	return ERROR_OK;
+}
+
+void target_mem_cache_clear(struct target *target)
+{
+	struct mem_cache *cache = target->mem_cache;
+
+	if (!cache)
+		return;
+
+	while (cache->regions)
+	{
+		struct mem_cache_region *next = cache->regions->next;
+		free(cache->regions);
+		cache->regions = next;
+	}
+	mem_cache_free_lines(cache);
+}
+
+void target_mem_cache_invalidate(struct target *target)
+{
+	struct mem_cache *cache = target->mem_cache;
+	unsigned i;
+
+	if (!cache || !cache->lines)
+		return;
+
+	for (i = 0; i < MEM_CACHE_LINES; i++)
+		cache->lines[i].valid = false;
+}
+
+void target_mem_cache_invalidate_range(struct target *target,
+		uint32_t address, uint32_t size)
+{
+	struct mem_cache *cache = target->mem_cache;
+	unsigned i;
+
+	if (!cache || !cache->lines || size == 0)
+		return;
+
+	for (i = 0; i < MEM_CACHE_LINES; i++)
+	{
+		struct mem_cache_line *line = &cache->lines[i];
+
+		/* overlap test which doesn't mind the top of memory */
+		if (line->valid
+				&& (line->address - address < size
+					|| address - line->address < cache->line_size))
+			line->valid = false;
+	}
+}
+
+bool target_mem_cache_covers(struct target *target,
+		uint32_t address, uint32_t size)
+{
+	struct mem_cache *cache = target->mem_cache;
+	struct mem_cache_region *region;
+
+	if (!cache || !cache->regions || size == 0)
+		return false;
+
+	/* memory only holds still while the core does */
+	if (target->state != TARGET_HALTED || target->running_alg)
+		return false;
+
+	for (region = cache->regions; region; region = region->next)
+	{
+		if (address - region->address < region->size
+				&& size <= region->size - (address - region->address))
+			return true;
+	}
+
+	return false;
+}
+
+static struct mem_cache_line *mem_cache_slot(struct mem_cache *cache,
+		uint32_t line_address, uint8_t **data)
+{
+	unsigned i = (line_address / cache->line_size) % MEM_CACHE_LINES;
+
+	*data = cache->data + i * cache->line_size;
+	return &cache->lines[i];
+}
+
+static bool mem_cache_hit(struct mem_cache *cache, uint32_t line_address)
+{
+	uint8_t *data;
+	struct mem_cache_line *line = mem_cache_slot(cache, line_address, &data);
+
+	return line->valid && line->address == line_address;
+}
+
+/* Copy the part of @a src, which holds @a len bytes starting @a pos bytes
+ * into the first line, that falls in the @a size bytes requested at
+ * @a skip bytes into that line.
+ */
+static void mem_cache_copy_out(uint8_t *buffer, uint32_t size, uint32_t skip,
+		uint32_t pos, const uint8_t *src, uint32_t len)
+{
+	uint32_t from = (pos < skip) ? skip - pos : 0;
+	uint32_t to = pos + from - skip;
+
+	if (from >= len || to >= size)
+		return;
+
+	len -= from;
+	if (len > size - to)
+		len = size - to;
+	memcpy(buffer + to, src + from, len);
+}
+
+int target_mem_cache_read(struct target *target,
+		uint32_t address, uint32_t size, uint8_t *buffer)
+{
+	struct mem_cache *cache = target->mem_cache;
+	uint32_t line_size = cache->line_size;
+	uint32_t first = address & ~(line_size - 1);
+	/* offset of the requested data from the first line */
+	uint32_t skip = address - first;
+	uint32_t num_lines = (skip + size + line_size - 1) / line_size;
+	uint32_t i = 0;
+
+	while (i < num_lines)
+	{
+		uint32_t line_address = first + i * line_size;
+		uint32_t run, j;
+		uint8_t *fill;
+		int retval;
+
+		if (mem_cache_hit(cache, line_address))
+		{
+			uint8_t *data;
+
+			mem_cache_slot(cache, line_address, &data);
+			mem_cache_copy_out(buffer, size, skip,
+					i * line_size, data, line_size);
+			perf_count(PERF_TARGET_CACHE_HITS, 1);
+			i++;
+			continue;
+		}
+
+		/* fetch a run of missing lines with a single read */
+		for (run = 1; i + run < num_lines; run++)
+		{
+			if (mem_cache_hit(cache, line_address + run * line_size))
+				break;
+		}
+
+		fill = malloc(run * line_size);
+		if (!fill)
+			return ERROR_FAIL;
+
+		retval = target->type->read_memory(target, line_address,
+				4, run * line_size / 4, fill);
+		if (retval != ERROR_OK)
+		{
+			free(fill);
+			return retval;
+		}
+		perf_count(PERF_TARGET_CACHE_MISSES, run);
+
+		for (j = 0; j < run; j++)
+		{
+			uint8_t *data;
+			struct mem_cache_line *line = mem_cache_slot(cache,
+					line_address + j * line_size, &data);
+
+			memcpy(data, fill + j * line_size, line_size);
+			line->address = line_address + j * line_size;
+			line->valid = true;
+		}
+
+		mem_cache_copy_out(buffer, size, skip,
+				i * line_size, fill, run * line_size);
+
+		free(fill);
+		i += run;
+	}
+
+	return ERROR_OK;
+}
@@ -0,0 +1,71 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef TARGET_MEM_CACHE_H
+#define TARGET_MEM_CACHE_H
+
+#include <helper/types.h>
+
+struct target;
+
+/**
+ * A host side cache of target memory, for regions the user marked
+ * cacheable with "$target_name mem_cache add".  Lines are only filled
+ * and used while the target is halted.  Resume, step, any target event
+ * (including reset), writes and flash operations invalidate them.
+ */
+struct mem_cache_region
+{
+	uint32_t address;
+	uint32_t size;
+	struct mem_cache_region *next;
+};
+
+struct mem_cache_line
+{
+	bool valid;
+	uint32_t address;
+};
+
+struct mem_cache
+{
+	uint32_t line_size;
+	/* direct mapped; line i holds data + i * line_size */
+	struct mem_cache_line *lines;
+	uint8_t *data;
+	struct mem_cache_region *regions;
+};
+
+/// Set the line size, which must be a power of two from 4 to 4096.
+int target_mem_cache_set_line_size(struct target *target, uint32_t line_size);
+/// Mark [address, address + size) cacheable; both must be line aligned.
+int target_mem_cache_add_region(struct target *target,
+		uint32_t address, uint32_t size);
+/// Forget all regions, turning the cache off.
+void target_mem_cache_clear(struct target *target);
+
+void target_mem_cache_invalidate(struct target *target);
+void target_mem_cache_invalidate_range(struct target *target,
+		uint32_t address, uint32_t size);
+
+/// True if a read of [address, address + size) can go through the cache.
+bool target_mem_cache_covers(struct target *target,
+		uint32_t address, uint32_t size);
+/// Read through the cache; only valid when target_mem_cache_covers().
+int target_mem_cache_read(struct target *target,
+		uint32_t address, uint32_t size, uint8_t *buffer);
+
+#endif /* TARGET_MEM_CACHE_H */
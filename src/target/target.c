@@ -34,6 +34,7 @@
 #endif
 
 #include <helper/time_support.h>
+#include <helper/perf.h>
 #include <jtag/jtag.h>
 #include <flash/nor/core.h>
 
@@ -44,6 +45,7 @@
 #include "register.h"
 #include "trace.h"
 #include "image.h"
+#include "mem_cache.h"
 
 
 static int target_array2mem(Jim_Interp *interp, struct target *target,
@@ -51,6 +53,9 @@ static int target_array2mem(Jim_Interp *interp, struct target *target,
 static int target_mem2array(Jim_Interp *interp, struct target *target,
 		int argc, Jim_Obj *const *argv);
 static int target_register_user_commands(struct command_context *cmd_ctx);
+static int target_backup_working_areas(struct target *target,
+		uint32_t address, uint32_t size);
+static int target_backup_unwritten_working_areas(struct target *target);
 
 /* targets */
 extern struct target_type arm7tdmi_target;
@@ -376,6 +381,14 @@ struct target* get_current_target(struct command_context *cmd_ctx)
 	return target;
 }
 
+/* writes collected by write combining must land before anything else */
+static int target_write_barrier(struct target *target)
+{
+	if (target->access_queue_count == 0)
+		return ERROR_OK;
+	return target_flush(target);
+}
+
 int target_poll(struct target *target)
 {
 	int retval;
@@ -472,6 +485,12 @@ int target_resume(struct target *target, int current, uint32_t address, int hand
 		return ERROR_FAIL;
 	}
 
+	retval = target_write_barrier(target);
+	if (retval != ERROR_OK)
+		return retval;
+
+	target_mem_cache_invalidate(target);
+
 	/* note that resume *must* be asynchronous. The CPU can halt before
 	 * we poll. The CPU can even halt at the current PC as a result of
 	 * a software breakpoint being inserted by (a bug?) the application.
@@ -658,6 +677,14 @@ int target_run_algorithm(struct target *target,
 		goto done;
 	}
 
+	retval = target_write_barrier(target);
+	if (retval != ERROR_OK)
+		goto done;
+
+	retval = target_backup_unwritten_working_areas(target);
+	if (retval != ERROR_OK)
+		goto done;
+
 	target->running_alg = true;
 	retval = target->type->run_algorithm(target,
 			num_mem_params, mem_params,
@@ -669,34 +696,491 @@ done:
 	return retval;
 }
 
+int target_start_algorithm(struct target *target,
+		int num_mem_params, struct mem_param *mem_params,
+		int num_reg_params, struct reg_param *reg_params,
+		uint32_t entry_point, uint32_t exit_point,
+		void *arch_info)
+{
+	int retval;
+
+	if (!target_was_examined(target))
+	{
+		LOG_ERROR("Target not examined yet");
+		return ERROR_FAIL;
+	}
+	if (!target->type->start_algorithm) {
+		LOG_ERROR("Target type '%s' does not support %s",
+				target_type_name(target), __func__);
+		return ERROR_FAIL;
+	}
+	if (target->running_alg) {
+		LOG_ERROR("Target is already running an algorithm");
+		return ERROR_FAIL;
+	}
+
+	retval = target_write_barrier(target);
+	if (retval != ERROR_OK)
+		return retval;
+
+	retval = target_backup_unwritten_working_areas(target);
+	if (retval != ERROR_OK)
+		return retval;
+
+	target->running_alg = true;
+	retval = target->type->start_algorithm(target,
+			num_mem_params, mem_params,
+			num_reg_params, reg_params,
+			entry_point, exit_point, arch_info);
+	if (retval != ERROR_OK)
+		target->running_alg = false;
+
+	return retval;
+}
+
+int target_wait_algorithm(struct target *target,
+		int num_mem_params, struct mem_param *mem_params,
+		int num_reg_params, struct reg_param *reg_params,
+		uint32_t exit_point, int timeout_ms,
+		void *arch_info)
+{
+	int retval;
+
+	if (!target->running_alg) {
+		LOG_ERROR("No algorithm is running");
+		return ERROR_FAIL;
+	}
+
+	retval = target->type->wait_algorithm(target,
+			num_mem_params, mem_params,
+			num_reg_params, reg_params,
+			exit_point, timeout_ms, arch_info);
+	target->running_alg = false;
+
+	return retval;
+}
+
+int target_begin_algorithm_session(struct target *target, void *arch_info)
+{
+	if (!target_was_examined(target))
+	{
+		LOG_ERROR("Target not examined yet");
+		return ERROR_FAIL;
+	}
+	if (!target->type->begin_algorithm_session)
+		return ERROR_OK;
+
+	return target->type->begin_algorithm_session(target, arch_info);
+}
+
+int target_end_algorithm_session(struct target *target, void *arch_info)
+{
+	if (!target->type->end_algorithm_session)
+		return ERROR_OK;
+
+	return target->type->end_algorithm_session(target, arch_info);
+}
+
+
+static void target_count_memory_access(bool write, uint32_t size, uint32_t count)
+{
+	static const enum perf_counter counters[2][3] = {
+		{ PERF_TARGET_READ_U8, PERF_TARGET_READ_U16, PERF_TARGET_READ_U32 },
+		{ PERF_TARGET_WRITE_U8, PERF_TARGET_WRITE_U16, PERF_TARGET_WRITE_U32 },
+	};
+
+	if (size == 1 || size == 2 || size == 4)
+		perf_count(counters[write][size / 2], 1);
+	perf_count(write ? PERF_TARGET_WRITE_BYTES : PERF_TARGET_READ_BYTES,
+			size * count);
+}
 
 int target_read_memory(struct target *target,
 		uint32_t address, uint32_t size, uint32_t count, uint8_t *buffer)
 {
+	int retval = target_write_barrier(target);
+	if (retval != ERROR_OK)
+		return retval;
+
+	target_count_memory_access(false, size, count);
+
+	if (target_mem_cache_covers(target, address, size * count))
+		return target_mem_cache_read(target, address, size * count, buffer);
+
 	return target->type->read_memory(target, address, size, count, buffer);
 }
 
+/* validate the items of a vector access, counting and preparing for them */
+static int target_check_memory_items(struct target *target,
+		struct target_memory_item *items, unsigned count)
+{
+	unsigned i;
+	int retval;
+
+	for (i = 0; i < count; i++)
+	{
+		uint32_t size = items[i].size;
+
+		if (size != 1 && size != 2 && size != 4)
+			return ERROR_INVALID_ARGUMENTS;
+		if (items[i].address & (size - 1))
+			return ERROR_TARGET_UNALIGNED_ACCESS;
+		target_count_memory_access(items[i].write, size, 1);
+
+		if (!items[i].write)
+			continue;
+
+		target_mem_cache_invalidate_range(target, items[i].address, size);
+		retval = target_backup_working_areas(target, items[i].address, size);
+		if (retval != ERROR_OK)
+			return retval;
+	}
+
+	return ERROR_OK;
+}
+
+static int target_read_items(struct target *target,
+		struct target_memory_item *items, unsigned count)
+{
+	unsigned i;
+	int retval = ERROR_OK;
+
+	if (target->type->read_memory_vector)
+		return target->type->read_memory_vector(target, items, count);
+
+	/* one round trip per item */
+	for (i = 0; i < count && retval == ERROR_OK; i++)
+	{
+		uint8_t value_buf[4];
+
+		retval = target->type->read_memory(target, items[i].address,
+				items[i].size, 1, value_buf);
+		if (retval != ERROR_OK)
+			break;
+
+		switch (items[i].size) {
+		case 4:
+			items[i].value = target_buffer_get_u32(target, value_buf);
+			break;
+		case 2:
+			items[i].value = target_buffer_get_u16(target, value_buf);
+			break;
+		default:
+			items[i].value = value_buf[0];
+			break;
+		}
+	}
+
+	return retval;
+}
+
+static int target_write_items(struct target *target,
+		struct target_memory_item *items, unsigned count)
+{
+	unsigned i;
+	int retval = ERROR_OK;
+
+	if (target->type->write_memory_vector)
+		return target->type->write_memory_vector(target, items, count);
+
+	/* one round trip per item */
+	for (i = 0; i < count && retval == ERROR_OK; i++)
+	{
+		uint8_t value_buf[4];
+
+		switch (items[i].size) {
+		case 4:
+			target_buffer_set_u32(target, value_buf, items[i].value);
+			break;
+		case 2:
+			target_buffer_set_u16(target, value_buf, items[i].value);
+			break;
+		default:
+			value_buf[0] = items[i].value;
+			break;
+		}
+
+		retval = target->type->write_memory(target, items[i].address,
+				items[i].size, 1, value_buf);
+	}
+
+	return retval;
+}
+
+int target_read_memory_vector(struct target *target,
+		struct target_memory_item *items, unsigned count)
+{
+	unsigned i;
+	int retval;
+
+	/* nothing to do; backends may assume at least one item */
+	if (count == 0)
+		return ERROR_OK;
+
+	if (!target_was_examined(target))
+	{
+		LOG_ERROR("Target not examined yet");
+		return ERROR_FAIL;
+	}
+
+	retval = target_write_barrier(target);
+	if (retval != ERROR_OK)
+		return retval;
+
+	for (i = 0; i < count; i++)
+		items[i].write = false;
+
+	retval = target_check_memory_items(target, items, count);
+	if (retval != ERROR_OK)
+		return retval;
+
+	return target_read_items(target, items, count);
+}
+
+int target_write_memory_vector(struct target *target,
+		struct target_memory_item *items, unsigned count)
+{
+	unsigned i;
+	int retval;
+
+	/* nothing to do; backends may assume at least one item */
+	if (count == 0)
+		return ERROR_OK;
+
+	if (!target_was_examined(target))
+	{
+		LOG_ERROR("Target not examined yet");
+		return ERROR_FAIL;
+	}
+
+	retval = target_write_barrier(target);
+	if (retval != ERROR_OK)
+		return retval;
+
+	for (i = 0; i < count; i++)
+		items[i].write = true;
+
+	retval = target_check_memory_items(target, items, count);
+	if (retval != ERROR_OK)
+		return retval;
+
+	return target_write_items(target, items, count);
+}
+
+int target_access_memory_vector(struct target *target,
+		struct target_memory_item *items, unsigned count)
+{
+	unsigned i, run;
+	int retval;
+
+	/* nothing to do; backends may assume at least one item */
+	if (count == 0)
+		return ERROR_OK;
+
+	if (!target_was_examined(target))
+	{
+		LOG_ERROR("Target not examined yet");
+		return ERROR_FAIL;
+	}
+
+	retval = target_write_barrier(target);
+	if (retval != ERROR_OK)
+		return retval;
+
+	retval = target_check_memory_items(target, items, count);
+	if (retval != ERROR_OK)
+		return retval;
+
+	if (target->type->access_memory_vector)
+		return target->type->access_memory_vector(target, items, count);
+
+	/* one vector per run of reads or writes */
+	for (i = 0; i < count && retval == ERROR_OK; i += run)
+	{
+		for (run = 1; i + run < count; run++)
+		{
+			if (items[i + run].write != items[i].write)
+				break;
+		}
+
+		if (items[i].write)
+			retval = target_write_items(target, items + i, run);
+		else
+			retval = target_read_items(target, items + i, run);
+	}
+
+	return retval;
+}
+
+void target_begin_write_combining(struct target *target)
+{
+	target->write_combining++;
+}
+
+int target_end_write_combining(struct target *target)
+{
+	if (target->write_combining == 0)
+	{
+		LOG_ERROR("BUG: unbalanced target_end_write_combining()");
+		return ERROR_FAIL;
+	}
+
+	if (--target->write_combining)
+		return ERROR_OK;
+
+	return target_flush(target);
+}
+
+int target_flush(struct target *target)
+{
+	unsigned i, count = target->access_queue_count;
+	int retval;
+
+	if (count == 0)
+		return ERROR_OK;
+
+	target->access_queue_count = 0;
+	retval = target_access_memory_vector(target, target->access_queue, count);
+
+	/* hand the values to the async readers */
+	for (i = 0; i < count; i++)
+	{
+		struct target_async_read *handle = target->access_queue_reads[i];
+
+		if (!handle)
+			continue;
+		handle->value = target->access_queue[i].value;
+		handle->retval = retval;
+		handle->done = true;
+	}
+
+	return retval;
+}
+
+/* add one access to the queue which target_flush() sends */
+static int target_queue_access(struct target *target, uint32_t address,
+		uint32_t size, uint32_t value, struct target_async_read *handle)
+{
+	struct target_memory_item *item;
+
+	/* don't let a long sequence build up without bound */
+	if (target->access_queue_count == 1024)
+	{
+		int retval = target_flush(target);
+		if (retval != ERROR_OK)
+			return retval;
+	}
+
+	if (target->access_queue_count == target->access_queue_size)
+	{
+		unsigned n = target->access_queue_size ? 2 * target->access_queue_size : 32;
+		struct target_async_read **reads;
+
+		item = realloc(target->access_queue, n * sizeof(*item));
+		if (item == NULL)
+		{
+			LOG_ERROR("out of memory");
+			return ERROR_FAIL;
+		}
+		target->access_queue = item;
+
+		reads = realloc(target->access_queue_reads, n * sizeof(*reads));
+		if (reads == NULL)
+		{
+			LOG_ERROR("out of memory");
+			return ERROR_FAIL;
+		}
+		target->access_queue_reads = reads;
+		target->access_queue_size = n;
+	}
+
+	target->access_queue_reads[target->access_queue_count] = handle;
+	item = &target->access_queue[target->access_queue_count++];
+	item->address = address;
+	item->size = size;
+	item->value = value;
+	item->write = (handle == NULL);
+
+	return ERROR_OK;
+}
+
+/* collect one write while write combining */
+static int target_write_combined(struct target *target,
+		uint32_t address, uint32_t size, uint32_t value)
+{
+	return target_queue_access(target, address, size, value, NULL);
+}
+
+int target_read_u32_async(struct target *target, uint32_t address,
+		struct target_async_read *handle)
+{
+	if (!target_was_examined(target))
+	{
+		LOG_ERROR("Target not examined yet");
+		return ERROR_FAIL;
+	}
+	if (address & 3)
+		return ERROR_TARGET_UNALIGNED_ACCESS;
+
+	handle->done = false;
+	handle->retval = ERROR_OK;
+	handle->value = 0;
+
+	return target_queue_access(target, address, 4, 0, handle);
+}
+
 static int target_read_phys_memory(struct target *target,
 		uint32_t address, uint32_t size, uint32_t count, uint8_t *buffer)
 {
+	int retval = target_write_barrier(target);
+	if (retval != ERROR_OK)
+		return retval;
+
 	return target->type->read_phys_memory(target, address, size, count, buffer);
 }
 
 int target_write_memory(struct target *target,
 		uint32_t address, uint32_t size, uint32_t count, uint8_t *buffer)
 {
+	int retval = target_write_barrier(target);
+	if (retval != ERROR_OK)
+		return retval;
+
+	target_count_memory_access(true, size, count);
+	target_mem_cache_invalidate_range(target, address, size * count);
+
+	retval = target_backup_working_areas(target, address, size * count);
+	if (retval != ERROR_OK)
+		return retval;
+
 	return target->type->write_memory(target, address, size, count, buffer);
 }
 
 static int target_write_phys_memory(struct target *target,
 		uint32_t address, uint32_t size, uint32_t count, uint8_t *buffer)
 {
+	int retval = target_write_barrier(target);
+	if (retval != ERROR_OK)
+		return retval;
+
+	/* the cache holds virtual addresses */
+	target_mem_cache_invalidate(target);
 	return target->type->write_phys_memory(target, address, size, count, buffer);
 }
 
 int target_bulk_write_memory(struct target *target,
 		uint32_t address, uint32_t count, uint8_t *buffer)
 {
+	int retval = target_write_barrier(target);
+	if (retval != ERROR_OK)
+		return retval;
+
+	target_mem_cache_invalidate_range(target, address, 4 * count);
+
+	retval = target_backup_working_areas(target, address, 4 * count);
+	if (retval != ERROR_OK)
+		return retval;
+
 	return target->type->bulk_write_memory(target, address, count, buffer);
 }
 
@@ -738,6 +1222,11 @@ int target_get_gdb_reg_list(struct target *target,
 int target_step(struct target *target,
 		int current, uint32_t address, int handle_breakpoints)
 {
+	int retval = target_write_barrier(target);
+	if (retval != ERROR_OK)
+		return retval;
+
+	target_mem_cache_invalidate(target);
 	return target->type->step(target, current, address, handle_breakpoints);
 }
 
@@ -1019,6 +1508,9 @@ int target_call_event_callbacks(struct target *target, enum target_event event)
 		target_call_event_callbacks(target, TARGET_EVENT_GDB_HALT);
 	}
 
+	/* halts, resumes and resets all mean memory may have changed */
+	target_mem_cache_invalidate(target);
+
 	LOG_DEBUG("target event %i (%s)",
 			  event,
 			  Jim_Nvp_value2name_simple(nvp_target_event, event)->name);
@@ -1104,9 +1596,149 @@ int target_call_timer_callbacks_now(void)
 	return target_call_timer_callbacks_check_time(0);
 }
 
-int target_alloc_working_area_try(struct target *target, uint32_t size, struct working_area **area)
+/*
+ * The working area is kept as a list of blocks, in address order, which
+ * covers all of it; each block is either free or allocated.  Allocation
+ * takes the smallest free block which is big enough and splits off the
+ * rest, and freeing merges neighbouring free blocks again.
+ *
+ * With "-work-area-backup", an allocated block's original contents are
+ * only saved when something is about to change them: just before the
+ * host writes into the block, or before an algorithm runs (for blocks
+ * the host never wrote, e.g. stacks).  Only the range which was saved
+ * is restored when the block is freed.
+ */
+
+/* Save the part of [start, end) (relative to the area's address) which
+ * isn't saved yet.  The saved range only grows, and stays contiguous.
+ */
+static int target_backup_working_area(struct target *target,
+		struct working_area *area, uint32_t start, uint32_t end)
+{
+	int retval;
+
+	start &= ~3;
+	end = (end + 3) & ~3;
+	if (end > area->size)
+		end = area->size;
+
+	if (area->backup == NULL)
+	{
+		area->backup = malloc(area->size);
+		if (area->backup == NULL)
+			return ERROR_FAIL;
+		area->backup_start = area->backup_end = start;
+	}
+
+	if (start < area->backup_start)
+	{
+		retval = target_read_memory(target, area->address + start, 4,
+				(area->backup_start - start) / 4, area->backup + start);
+		if (retval != ERROR_OK)
+			return retval;
+		area->backup_start = start;
+	}
+
+	if (end > area->backup_end)
+	{
+		retval = target_read_memory(target, area->address + area->backup_end, 4,
+				(end - area->backup_end) / 4, area->backup + area->backup_end);
+		if (retval != ERROR_OK)
+			return retval;
+		area->backup_end = end;
+	}
+
+	return ERROR_OK;
+}
+
+/* Called before the host writes [address, address + size) */
+static int target_backup_working_areas(struct target *target,
+		uint32_t address, uint32_t size)
+{
+	struct working_area *c;
+	int retval;
+
+	if (!target->backup_working_area)
+		return ERROR_OK;
+
+	for (c = target->working_areas; c; c = c->next)
+	{
+		uint32_t start, end;
+
+		if (c->free || address >= c->address + c->size
+				|| address + size <= c->address)
+			continue;
+
+		start = (address > c->address) ? address - c->address : 0;
+		end = MIN(address + size - c->address, c->size);
+
+		retval = target_backup_working_area(target, c, start, end);
+		if (retval != ERROR_OK)
+			return retval;
+	}
+
+	return ERROR_OK;
+}
+
+/* Called before running an algorithm.  Blocks the host wrote to hold
+ * the algorithm's input, and their written range is saved already; the
+ * others (stacks, result buffers) may be clobbered anywhere, so save
+ * those completely.
+ */
+static int target_backup_unwritten_working_areas(struct target *target)
+{
+	struct working_area *c;
+	int retval;
+
+	if (!target->backup_working_area)
+		return ERROR_OK;
+
+	for (c = target->working_areas; c; c = c->next)
+	{
+		if (c->free || c->backup)
+			continue;
+
+		retval = target_backup_working_area(target, c, 0, c->size);
+		if (retval != ERROR_OK)
+			return retval;
+	}
+
+	return ERROR_OK;
+}
+
+static int target_restore_working_area(struct target *target,
+		struct working_area *area)
+{
+	if (area->backup == NULL || area->backup_end == area->backup_start)
+		return ERROR_OK;
+
+	return target_write_memory(target, area->address + area->backup_start, 4,
+			(area->backup_end - area->backup_start) / 4,
+			area->backup + area->backup_start);
+}
+
+static void target_merge_working_areas(struct target *target)
 {
 	struct working_area *c = target->working_areas;
+
+	while (c && c->next)
+	{
+		struct working_area *next = c->next;
+
+		if (c->free && next->free)
+		{
+			c->size += next->size;
+			c->next = next->next;
+			free(next);
+		}
+		else
+			c = next;
+	}
+}
+
+int target_alloc_working_area_try(struct target *target, uint32_t size, struct working_area **area)
+{
+	struct working_area *c;
 	struct working_area *new_wa = NULL;
 
 	/* Reevaluate working area address based on MMU state*/
@@ -1144,6 +1776,19 @@ int target_alloc_working_area_try(struct target *target, uint32_t size, struct w
 				return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
 			}
 		}
+
+		/* start out with the whole working area free */
+		c = malloc(sizeof(struct working_area));
+		if (c == NULL)
+			return ERROR_FAIL;
+		c->address = target->working_area;
+		c->size = target->working_area_size;
+		c->free = 1;
+		c->backup = NULL;
+		c->backup_start = c->backup_end = 0;
+		c->user = NULL;
+		c->next = NULL;
+		target->working_areas = c;
 	}
 
 	/* only allocate multiples of 4 byte */
@@ -1153,72 +1798,51 @@ int target_alloc_working_area_try(struct target *target, uint32_t size, struct w
 		size = (size + 3) & (~3);
 	}
 
-	/* see if there's already a matching working area */
-	while (c)
-	{
-		if ((c->free) && (c->size == size))
-		{
-			new_wa = c;
-			break;
-		}
-		c = c->next;
-	}
-
-	/* if not, allocate a new one */
-	if (!new_wa)
-	{
-		struct working_area **p = &target->working_areas;
-		uint32_t first_free = target->working_area;
-		uint32_t free_size = target->working_area_size;
-
-		c = target->working_areas;
-		while (c)
-		{
-			first_free += c->size;
-			free_size -= c->size;
-			p = &c->next;
-			c = c->next;
-		}
-
-		if (free_size < size)
-		{
-			return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
-		}
-
-		LOG_DEBUG("allocated new working area at address 0x%08x", (unsigned)first_free);
-
-		new_wa = malloc(sizeof(struct working_area));
-		new_wa->next = NULL;
-		new_wa->size = size;
-		new_wa->address = first_free;
+	/* best fit: the smallest free block which is big enough */
+	for (c = target->working_areas; c; c = c->next)
+	{
+		if (c->free && c->size >= size
+				&& (new_wa == NULL || c->size < new_wa->size))
+			new_wa = c;
+	}
 
-		if (target->backup_working_area)
-		{
-			int retval;
-			new_wa->backup = malloc(new_wa->size);
-			if ((retval = target_read_memory(target, new_wa->address, 4, new_wa->size / 4, new_wa->backup)) != ERROR_OK)
-			{
-				free(new_wa->backup);
-				free(new_wa);
-				return retval;
-			}
-		}
-		else
-		{
-			new_wa->backup = NULL;
-		}
+	if (!new_wa)
+	{
+		perf_count(PERF_WORKING_AREA_FAILS, 1);
+		return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
+	}
 
-		/* put new entry in list */
-		*p = new_wa;
+	/* split off what we don't need */
+	if (new_wa->size > size)
+	{
+		c = malloc(sizeof(struct working_area));
+		if (c == NULL)
+			return ERROR_FAIL;
+		c->address = new_wa->address + size;
+		c->size = new_wa->size - size;
+		c->free = 1;
+		c->backup = NULL;
+		c->backup_start = c->backup_end = 0;
+		c->user = NULL;
+		c->next = new_wa->next;
+
+		new_wa->next = c;
+		new_wa->size = size;
 	}
 
-	/* mark as used, and return the new (reused) area */
+	LOG_DEBUG("allocated working area of %u bytes at address 0x%08x",
+			(unsigned)size, (unsigned)new_wa->address);
+
+	/* mark as used, and return the new area */
 	new_wa->free = 0;
 	*area = new_wa;
 
 	/* user pointer */
 	new_wa->user = area;
 
+	perf_count(PERF_WORKING_AREA_ALLOCS, 1);
+	perf_count(PERF_WORKING_AREA_BYTES, size);
+
 	return ERROR_OK;
 }
 
@@ -1235,30 +1859,29 @@ int target_alloc_working_area(struct target *target, uint32_t size, struct worki
 
 }
 
-static int target_free_working_area_restore(struct target *target, struct working_area *area, int restore)
+int target_free_working_area(struct target *target, struct working_area *area)
 {
+	int retval;
+
 	if (area->free)
 		return ERROR_OK;
 
-	if (restore && target->backup_working_area)
-	{
-		int retval;
-		if ((retval = target_write_memory(target, area->address, 4, area->size / 4, area->backup)) != ERROR_OK)
-			return retval;
-	}
+	retval = target_restore_working_area(target, area);
+	if (retval != ERROR_OK)
+		return retval;
 
+	free(area->backup);
+	area->backup = NULL;
 	area->free = 1;
 
 	/* mark user pointer invalid */
 	*area->user = NULL;
 	area->user = NULL;
 
-	return ERROR_OK;
-}
+	/* this may free "area" */
+	target_merge_working_areas(target);
 
-int target_free_working_area(struct target *target, struct working_area *area)
-{
-	return target_free_working_area_restore(target, area, 1);
+	return ERROR_OK;
 }
 
 /* free resources and restore memory, if restoring memory fails,
@@ -1271,16 +1894,23 @@ static void target_free_all_working_areas_restore(struct target *target, int res
 	while (c)
 	{
 		struct working_area *next = c->next;
-		target_free_working_area_restore(target, c, restore);
 
-		if (c->backup)
-			free(c->backup);
+		if (!c->free)
+		{
+			if (restore)
+				target_restore_working_area(target, c);
+
+			/* mark user pointer invalid */
+			*c->user = NULL;
+		}
 
+		free(c->backup);
 		free(c);
 
 		c = next;
 	}
 
+	/* the MMU state is evaluated again on the next allocation */
 	target->working_areas = NULL;
 }
 
@@ -1365,7 +1995,7 @@ int target_write_buffer(struct target *target, uint32_t address, uint32_t size,
 		/* use bulk writes above a certain limit. This may have to be changed */
 		if (aligned > 128)
 		{
-			if ((retval = target->type->bulk_write_memory(target, address, aligned / 4, buffer)) != ERROR_OK)
+			if ((retval = target_bulk_write_memory(target, address, aligned / 4, buffer)) != ERROR_OK)
 				return retval;
 		}
 		else
@@ -1486,6 +2116,10 @@ int target_checksum_memory(struct target *target, uint32_t address, uint32_t siz
 		return ERROR_FAIL;
 	}
 
+	retval = target_write_barrier(target);
+	if (retval != ERROR_OK)
+		return retval;
+
 	if ((retval = target->type->checksum_memory(target, address,
 		size, &checksum)) != ERROR_OK)
 	{
@@ -1531,6 +2165,10 @@ int target_blank_check_memory(struct target *target, uint32_t address, uint32_t
 	if (target->type->blank_check_memory == 0)
 		return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
 
+	retval = target_write_barrier(target);
+	if (retval != ERROR_OK)
+		return retval;
+
 	retval = target->type->blank_check_memory(target, address, size, blank);
 
 	return retval;
@@ -1631,6 +2269,9 @@ int target_write_u32(struct target *target, uint32_t address, uint32_t value)
 			  address,
 			  value);
 
+	if (target->write_combining)
+		return target_write_combined(target, address, 4, value);
+
 	target_buffer_set_u32(target, value_buf, value);
 	if ((retval = target_write_memory(target, address, 4, 1, value_buf)) != ERROR_OK)
 	{
@@ -1654,6 +2295,9 @@ int target_write_u16(struct target *target, uint32_t address, uint16_t value)
 			  address,
 			  value);
 
+	if (target->write_combining)
+		return target_write_combined(target, address, 2, value);
+
 	target_buffer_set_u16(target, value_buf, value);
 	if ((retval = target_write_memory(target, address, 2, 1, value_buf)) != ERROR_OK)
 	{
@@ -1675,6 +2319,9 @@ int target_write_u8(struct target *target, uint32_t address, uint8_t value)
 	LOG_DEBUG("address: 0x%8.8" PRIx32 ", value: 0x%2.2x",
 			  address, value);
 
+	if (target->write_combining)
+		return target_write_combined(target, address, 1, value);
+
 	if ((retval = target_write_memory(target, address, 1, 1, &value)) != ERROR_OK)
 	{
 		LOG_DEBUG("failed: %i", retval);
@@ -2507,7 +3154,7 @@ static COMMAND_HELPER(parse_load_image_command_CMD_ARGV, struct image *image,
 
 COMMAND_HANDLER(handle_load_image_command)
 {
-	uint8_t *buffer;
+	uint8_t *data, *buffer;
 	size_t buf_cnt;
 	uint32_t image_size;
 	uint32_t min_address = 0;
@@ -2534,20 +3181,9 @@ COMMAND_HANDLER(handle_load_image_command)
 	retval = ERROR_OK;
 	for (i = 0; i < image.num_sections; i++)
 	{
-		buffer = malloc(image.sections[i].size);
-		if (buffer == NULL)
-		{
-			command_print(CMD_CTX,
-						  "error allocating buffer for section (%d bytes)",
-						  (int)(image.sections[i].size));
-			break;
-		}
-
-		if ((retval = image_read_section(&image, i, 0x0, image.sections[i].size, buffer, &buf_cnt)) != ERROR_OK)
-		{
-			free(buffer);
+		if ((retval = image_get_section(&image, i, 0x0, image.sections[i].size,
+				&data, &buffer, &buf_cnt)) != ERROR_OK)
 			break;
-		}
 
 		uint32_t offset = 0;
 		uint32_t length = buf_cnt;
@@ -2569,7 +3205,7 @@ COMMAND_HANDLER(handle_load_image_command)
 				length -= (image.sections[i].base_address + buf_cnt)-max_address;
 			}
 
-			if ((retval = target_write_buffer(target, image.sections[i].base_address + offset, length, buffer + offset)) != ERROR_OK)
+			if ((retval = target_write_buffer(target, image.sections[i].base_address + offset, length, data + offset)) != ERROR_OK)
 			{
 				free(buffer);
 				break;
@@ -2655,9 +3291,79 @@ COMMAND_HANDLER(handle_dump_image_command)
 	return retval;
 }
 
+/* granularity of the second level of verify_image checksums */
+#define VERIFY_CHUNK_SIZE	4096
+
+/* A section failed its checksum: checksum it again in chunks, then read
+ * back and compare only those chunks which differ.  Stops after 128
+ * differing bytes, as counted in *diffs.
+ */
+static int verify_image_chunks(struct command_context *cmd_ctx,
+		struct target *target, uint32_t address,
+		uint8_t *buffer, uint32_t size, int *diffs)
+{
+	uint8_t *data;
+	uint32_t offset;
+	int retval = ERROR_OK;
+
+	data = malloc(VERIFY_CHUNK_SIZE);
+	if (data == NULL)
+		return ERROR_FAIL;
+
+	for (offset = 0; offset < size; offset += VERIFY_CHUNK_SIZE)
+	{
+		uint32_t chunk = size - offset;
+		uint32_t checksum, mem_checksum;
+		uint32_t t;
+
+		if (chunk > VERIFY_CHUNK_SIZE)
+			chunk = VERIFY_CHUNK_SIZE;
+
+		retval = image_calculate_checksum(buffer + offset, chunk, &checksum);
+		if (retval != ERROR_OK)
+			break;
+		retval = target_checksum_memory(target, address + offset,
+				chunk, &mem_checksum);
+		if (retval != ERROR_OK)
+			break;
+		if (checksum == mem_checksum)
+			continue;
+
+		command_print(cmd_ctx, "range 0x%08" PRIx32 "-0x%08" PRIx32 " differs",
+				address + offset, address + offset + chunk - 1);
+
+		retval = target_read_buffer(target, address + offset, chunk, data);
+		if (retval != ERROR_OK)
+			break;
+
+		for (t = 0; t < chunk; t++)
+		{
+			if (data[t] == buffer[offset + t])
+				continue;
+
+			command_print(cmd_ctx,
+						  "diff %d address 0x%08x. Was 0x%02x instead of 0x%02x",
+						  *diffs,
+						  (unsigned)(address + offset + t),
+						  data[t],
+						  buffer[offset + t]);
+			if ((*diffs)++ >= 127)
+			{
+				command_print(cmd_ctx, "More than 128 errors, the rest are not printed.");
+				free(data);
+				return ERROR_OK;
+			}
+		}
+		keep_alive();
+	}
+
+	free(data);
+	return retval;
+}
+
 static COMMAND_HELPER(handle_verify_image_command_internal, int verify)
 {
-	uint8_t *buffer;
+	uint8_t *data, *buffer;
 	size_t buf_cnt;
 	uint32_t image_size;
 	int i;
@@ -2708,24 +3414,14 @@ static COMMAND_HELPER(handle_verify_image_command_internal, int verify)
 	retval = ERROR_OK;
 	for (i = 0; i < image.num_sections; i++)
 	{
-		buffer = malloc(image.sections[i].size);
-		if (buffer == NULL)
-		{
-			command_print(CMD_CTX,
-						  "error allocating buffer for section (%d bytes)",
-						  (int)(image.sections[i].size));
-			break;
-		}
-		if ((retval = image_read_section(&image, i, 0x0, image.sections[i].size, buffer, &buf_cnt)) != ERROR_OK)
-		{
-			free(buffer);
+		if ((retval = image_get_section(&image, i, 0x0, image.sections[i].size,
+				&data, &buffer, &buf_cnt)) != ERROR_OK)
 			break;
-		}
 
 		if (verify)
 		{
 			/* calculate checksum of image */
-			retval = image_calculate_checksum(buffer, buf_cnt, &checksum);
+			retval = image_calculate_checksum(data, buf_cnt, &checksum);
 			if (retval != ERROR_OK)
 			{
 				free(buffer);
@@ -2741,50 +3437,25 @@ static COMMAND_HELPER(handle_verify_image_command_internal, int verify)
 
 			if (checksum != mem_checksum)
 			{
-				/* failed crc checksum, fall back to a binary compare */
-				uint8_t *data;
-
+				/* failed crc checksum, narrow it down */
 				if (diffs == 0)
 				{
-					LOG_ERROR("checksum mismatch - attempting binary compare");
+					LOG_ERROR("checksum mismatch - comparing chunks");
 				}
 
-				data = (uint8_t*)malloc(buf_cnt);
-
-				/* Can we use 32bit word accesses? */
-				int size = 1;
-				int count = buf_cnt;
-				if ((count % 4) == 0)
+				retval = verify_image_chunks(CMD_CTX, target,
+						image.sections[i].base_address,
+						data, buf_cnt, &diffs);
+				if (diffs > 127)
 				{
-					size *= 4;
-					count /= 4;
+					free(buffer);
+					goto done;
 				}
-				retval = target_read_memory(target, image.sections[i].base_address, size, count, data);
-				if (retval == ERROR_OK)
+				if (retval != ERROR_OK)
 				{
-					uint32_t t;
-					for (t = 0; t < buf_cnt; t++)
-					{
-						if (data[t] != buffer[t])
-						{
-							command_print(CMD_CTX,
-										  "diff %d address 0x%08x. Was 0x%02x instead of 0x%02x",
-										  diffs,
-										  (unsigned)(t + image.sections[i].base_address),
-										  data[t],
-										  buffer[t]);
-							if (diffs++ >= 127)
-							{
-								command_print(CMD_CTX, "More than 128 errors, the rest are not printed.");
-								free(data);
-								free(buffer);
-								goto done;
-							}
-						}
-						keep_alive();
-					}
+					free(buffer);
+					break;
 				}
-				free(data);
 			}
 		} else
 		{
@@ -3139,46 +3810,32 @@ static void writeGmon(uint32_t *samples, uint32_t sampleNum, const char *filenam
 
 /* profiling samples the CPU PC as quickly as OpenOCD is able,
  * which will be used as a random sampling of PC */
-COMMAND_HANDLER(handle_profile_command)
+/**
+ * Sample the PC by halting and resuming the target as often as we can;
+ * any core can do this, but it is slow and it perturbs the program.
+ */
+int target_profiling_default(struct target *target, uint32_t *samples,
+		uint32_t max_num_samples, uint32_t *num_samples, uint32_t seconds)
 {
-	struct target *target = get_current_target(CMD_CTX);
 	struct timeval timeout, now;
+	uint32_t sample_count = 0;
+	int retval = ERROR_OK;
 
 	gettimeofday(&timeout, NULL);
-	if (CMD_ARGC != 2)
-	{
-		return ERROR_COMMAND_SYNTAX_ERROR;
-	}
-	unsigned offset;
-	COMMAND_PARSE_NUMBER(uint, CMD_ARGV[0], offset);
-
-	timeval_add_time(&timeout, offset, 0);
-
-	/**
-	 * @todo: Some cores let us sample the PC without the
-	 * annoying halt/resume step; for example, ARMv7 PCSR.
-	 * Provide a way to use that more efficient mechanism.
-	 */
-
-	command_print(CMD_CTX, "Starting profiling. Halting and resuming the target as often as we can...");
+	timeval_add_time(&timeout, seconds, 0);
 
-	static const int maxSample = 10000;
-	uint32_t *samples = malloc(sizeof(uint32_t)*maxSample);
-	if (samples == NULL)
-		return ERROR_OK;
+	LOG_INFO("Starting profiling. Halting and resuming the target as often as we can...");
 
-	int numSamples = 0;
 	/* hopefully it is safe to cache! We want to stop/restart as quickly as possible. */
 	struct reg *reg = register_get_by_name(target->reg_cache, "pc", 1);
 
 	for (;;)
 	{
-		int retval;
 		target_poll(target);
 		if (target->state == TARGET_HALTED)
 		{
 			uint32_t t=*((uint32_t *)reg->value);
-			samples[numSamples++]=t;
+			samples[sample_count++]=t;
 			retval = target_resume(target, 1, 0, 0, 0); /* current pc, addr = 0, do not handle breakpoints, not debugging */
 			target_poll(target);
 			alive_sleep(10); /* sleep 10ms, i.e. <100 samples/second. */
@@ -3186,13 +3843,10 @@ COMMAND_HANDLER(handle_profile_command)
 		{
 			/* We want to quickly sample the PC. */
 			if ((retval = target_halt(target)) != ERROR_OK)
-			{
-				free(samples);
-				return retval;
-			}
+				break;
 		} else
 		{
-			command_print(CMD_CTX, "Target not halted or running");
+			LOG_INFO("Target not halted or running");
 			retval = ERROR_OK;
 			break;
 		}
@@ -3202,28 +3856,74 @@ COMMAND_HANDLER(handle_profile_command)
 		}
 
 		gettimeofday(&now, NULL);
-		if ((numSamples >= maxSample) || ((now.tv_sec >= timeout.tv_sec) && (now.tv_usec >= timeout.tv_usec)))
+		if ((sample_count >= max_num_samples) || ((now.tv_sec >= timeout.tv_sec) && (now.tv_usec >= timeout.tv_usec)))
 		{
-			command_print(CMD_CTX, "Profiling completed. %d samples.", numSamples);
 			if ((retval = target_poll(target)) != ERROR_OK)
-			{
-				free(samples);
-				return retval;
-			}
+				break;
 			if (target->state == TARGET_HALTED)
 			{
 				target_resume(target, 1, 0, 0, 0); /* current pc, addr = 0, do not handle breakpoints, not debugging */
 			}
-			if ((retval = target_poll(target)) != ERROR_OK)
-			{
-				free(samples);
-				return retval;
-			}
-			writeGmon(samples, numSamples, CMD_ARGV[1]);
-			command_print(CMD_CTX, "Wrote %s", CMD_ARGV[1]);
+			retval = target_poll(target);
 			break;
 		}
 	}
+
+	*num_samples = sample_count;
+	return retval;
+}
+
+int target_profiling(struct target *target, uint32_t *samples,
+		uint32_t max_num_samples, uint32_t *num_samples, uint32_t seconds)
+{
+	if (!target_was_examined(target))
+	{
+		LOG_ERROR("Target not examined yet");
+		return ERROR_FAIL;
+	}
+
+	if (target->type->profiling)
+		return target->type->profiling(target, samples,
+				max_num_samples, num_samples, seconds);
+
+	return target_profiling_default(target, samples,
+			max_num_samples, num_samples, seconds);
+}
+
+COMMAND_HANDLER(handle_profile_command)
+{
+	struct target *target = get_current_target(CMD_CTX);
+
+	if (CMD_ARGC != 2)
+	{
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	}
+	unsigned offset;
+	COMMAND_PARSE_NUMBER(uint, CMD_ARGV[0], offset);
+
+	command_print(CMD_CTX, "Starting profiling...");
+
+	/* cores which can sample the PC without halting reach
+	 * thousands of samples per second
+	 */
+	static const uint32_t maxSample = 1000000;
+	uint32_t *samples = malloc(sizeof(uint32_t)*maxSample);
+	if (samples == NULL)
+		return ERROR_OK;
+
+	uint32_t numSamples = 0;
+	int retval = target_profiling(target, samples, maxSample,
+			&numSamples, offset);
+	if (retval != ERROR_OK)
+	{
+		free(samples);
+		return retval;
+	}
+
+	command_print(CMD_CTX, "Profiling completed. %" PRIu32 " samples.", numSamples);
+	writeGmon(samples, numSamples, CMD_ARGV[1]);
+	command_print(CMD_CTX, "Wrote %s", CMD_ARGV[1]);
+
 	free(samples);
 
 	return ERROR_OK;
@@ -3257,6 +3957,71 @@ static int new_int_array_element(Jim_Interp * interp, const char *varname, int i
 	return result;
 }
 
+static int target_mdw_multi(Jim_Interp *interp, struct target *target,
+		int argc, Jim_Obj *const *argv)
+{
+	struct target_memory_item *items;
+	Jim_Obj *list;
+	int i, retval;
+
+	/* argv[0..] = addresses of the words to read */
+	if (argc < 1) {
+		Jim_WrongNumArgs(interp, 1, argv, "address ...");
+		return JIM_ERR;
+	}
+
+	items = calloc(argc, sizeof(*items));
+	if (items == NULL)
+		return JIM_ERR;
+
+	for (i = 0; i < argc; i++) {
+		long l;
+
+		if (Jim_GetLong(interp, argv[i], &l) != JIM_OK) {
+			free(items);
+			return JIM_ERR;
+		}
+		items[i].address = l;
+		items[i].size = 4;
+	}
+
+	retval = target_read_memory_vector(target, items, argc);
+	if (retval != ERROR_OK) {
+		free(items);
+		Jim_SetResult(interp, Jim_NewEmptyStringObj(interp));
+		Jim_AppendStrings(interp, Jim_GetResult(interp),
+				"mdw_multi: read failed", NULL);
+		return JIM_ERR;
+	}
+
+	list = Jim_NewListObj(interp, NULL, 0);
+	for (i = 0; i < argc; i++)
+		Jim_ListAppendElement(interp, list,
+				Jim_NewIntObj(interp, items[i].value));
+	Jim_SetResult(interp, list);
+
+	free(items);
+	return JIM_OK;
+}
+
+static int jim_mdw_multi(Jim_Interp *interp, int argc, Jim_Obj *const *argv)
+{
+	struct command_context *context;
+	struct target *target;
+
+	context = current_command_context(interp);
+	assert (context != NULL);
+
+	target = get_current_target(context);
+	if (target == NULL)
+	{
+		LOG_ERROR("mdw_multi: no current target");
+		return JIM_ERR;
+	}
+
+	return target_mdw_multi(interp, target, argc - 1, argv + 1);
+}
+
 static int jim_mem2array(Jim_Interp *interp, int argc, Jim_Obj *const *argv)
 {
 	struct command_context *context;
@@ -4194,6 +4959,66 @@ static int jim_target_mem2array(Jim_Interp *interp,
 	return target_mem2array(interp, target, argc - 1, argv + 1);
 }
 
+static int jim_target_mdw_multi(Jim_Interp *interp,
+		int argc, Jim_Obj *const *argv)
+{
+	struct target *target = Jim_CmdPrivData(interp);
+	return target_mdw_multi(interp, target, argc - 1, argv + 1);
+}
+
+static int jim_target_mem_cache(Jim_Interp *interp,
+		int argc, Jim_Obj *const *argv)
+{
+	struct target *target = Jim_CmdPrivData(interp);
+	struct mem_cache_region *region;
+	const char *op;
+	jim_wide a, b;
+	int retval = ERROR_OK;
+
+	if (argc == 1)
+	{
+		if (!target->mem_cache || !target->mem_cache->regions)
+		{
+			command_print(NULL, "memory cache disabled");
+			return JIM_OK;
+		}
+		command_print(NULL, "line size %" PRIu32 " bytes",
+				target->mem_cache->line_size);
+		for (region = target->mem_cache->regions; region;
+				region = region->next)
+			command_print(NULL, "cacheable 0x%8.8" PRIx32 " size 0x%8.8" PRIx32,
+					region->address, region->size);
+		return JIM_OK;
+	}
+
+	op = Jim_GetString(argv[1], NULL);
+	if (strcmp(op, "clear") == 0 && argc == 2)
+		target_mem_cache_clear(target);
+	else if (strcmp(op, "invalidate") == 0 && argc == 2)
+		target_mem_cache_invalidate(target);
+	else if (strcmp(op, "line_size") == 0 && argc == 3)
+	{
+		if (Jim_GetWide(interp, argv[2], &a) != JIM_OK)
+			return JIM_ERR;
+		retval = target_mem_cache_set_line_size(target, a);
+	}
+	else if (strcmp(op, "add") == 0 && argc == 4)
+	{
+		if (Jim_GetWide(interp, argv[2], &a) != JIM_OK
+				|| Jim_GetWide(interp, argv[3], &b) != JIM_OK)
+			return JIM_ERR;
+		retval = target_mem_cache_add_region(target, a, b);
+	}
+	else
+	{
+		Jim_WrongNumArgs(interp, 1, argv,
+				"[clear|invalidate|line_size bytes|add address size]");
+		return JIM_ERR;
+	}
+
+	return (retval == ERROR_OK) ? JIM_OK : JIM_ERR;
+}
+
 static int jim_target_array2mem(Jim_Interp *interp,
 		int argc, Jim_Obj *const *argv)
 {
@@ -4512,6 +5337,22 @@ static const struct command_registration target_instance_command_handlers[] = {
 			"from target memory",
 		.usage = "arrayname bitwidth address count",
 	},
+	{
+		.name = "mdw_multi",
+		.mode = COMMAND_EXEC,
+		.jim_handler = jim_target_mdw_multi,
+		.help = "Reads 32-bit words from unrelated addresses "
+			"with a single queue flush, returning a list",
+		.usage = "address ...",
+	},
+	{
+		.name = "mem_cache",
+		.mode = COMMAND_ANY,
+		.jim_handler = jim_target_mem_cache,
+		.help = "Displays or configures the host side cache of "
+			"target memory, used while the target is halted",
+		.usage = "[clear|invalidate|line_size bytes|add address size]",
+	},
 	{
 		.name = "eventlist",
 		.mode = COMMAND_EXEC,
@@ -4947,7 +5788,7 @@ static void free_fastload(void)
 
 COMMAND_HANDLER(handle_fast_load_image_command)
 {
-	uint8_t *buffer;
+	uint8_t *data, *buffer;
 	size_t buf_cnt;
 	uint32_t image_size;
 	uint32_t min_address = 0;
@@ -4983,20 +5824,9 @@ COMMAND_HANDLER(handle_fast_load_image_command)
 	memset(fastload, 0, sizeof(struct FastLoad)*image.num_sections);
 	for (i = 0; i < image.num_sections; i++)
 	{
-		buffer = malloc(image.sections[i].size);
-		if (buffer == NULL)
-		{
-			command_print(CMD_CTX, "error allocating buffer for section (%d bytes)",
-						  (int)(image.sections[i].size));
-			retval = ERROR_FAIL;
-			break;
-		}
-
-		if ((retval = image_read_section(&image, i, 0x0, image.sections[i].size, buffer, &buf_cnt)) != ERROR_OK)
-		{
-			free(buffer);
+		if ((retval = image_get_section(&image, i, 0x0, image.sections[i].size,
+				&data, &buffer, &buf_cnt)) != ERROR_OK)
 			break;
-		}
 
 		uint32_t offset = 0;
 		uint32_t length = buf_cnt;
@@ -5029,7 +5859,7 @@ COMMAND_HANDLER(handle_fast_load_image_command)
 				retval = ERROR_FAIL;
 				break;
 			}
-			memcpy(fastload[i].data, buffer + offset, length);
+			memcpy(fastload[i].data, data + offset, length);
 			fastload[i].length = length;
 
 			image_size += length;
@@ -5327,6 +6157,14 @@ static const struct command_registration target_exec_command_handlers[] = {
 			"for script processing",
 		.usage = "arrayname bitwidth address count",
 	},
+	{
+		.name = "mdw_multi",
+		.mode = COMMAND_EXEC,
+		.jim_handler = jim_mdw_multi,
+		.help = "read 32-bit words from a list of unrelated addresses "
+			"with a single queue flush, returning a list of values",
+		.usage = "address ...",
+	},
 	{
 		.name = "array2mem",
 		.mode = COMMAND_EXEC,
@@ -35,6 +35,8 @@ struct breakpoint;
 struct watchpoint;
 struct mem_param;
 struct reg_param;
+struct mem_cache;
+struct target_async_read;
 
 
 /*
@@ -96,6 +98,9 @@ struct working_area
 	uint32_t size;
 	int free;
 	uint8_t *backup;
+	/* the part of the area saved in backup, relative to address */
+	uint32_t backup_start;
+	uint32_t backup_end;
 	struct working_area **user;
 	struct working_area *next;
 };
@@ -137,6 +142,12 @@ struct target
 	uint32_t working_area_size;			/* size in bytes */
 	uint32_t backup_working_area;			/* whether the content of the working area has to be preserved */
 	struct working_area *working_areas;/* list of allocated working areas */
+	struct mem_cache *mem_cache;		/* optional read cache, see mem_cache.h */
+	int write_combining;				/* nesting of target_begin_write_combining() */
+	struct target_memory_item *access_queue;	/* accesses target_flush() sends */
+	struct target_async_read **access_queue_reads;	/* where queued reads go */
+	unsigned access_queue_count;
+	unsigned access_queue_size;
 	enum target_debug_reason debug_reason;/* reason why the target entered debug state */
 	enum target_endianess endianness;	/* target endianess */
 	// also see: target_state_name()
@@ -376,6 +387,51 @@ int target_run_algorithm(struct target *target,
 		uint32_t entry_point, uint32_t exit_point,
 		int timeout_ms, void *arch_info);
 
+/**
+ * Start an algorithm like target_run_algorithm() does, but return as
+ * soon as it runs, so the host can talk to it (e.g. through a FIFO in
+ * target memory) while it works.  Finish with target_wait_algorithm().
+ *
+ * This routine is a wrapper for target->type->start_algorithm.
+ */
+int target_start_algorithm(struct target *target,
+		int num_mem_params, struct mem_param *mem_params,
+		int num_reg_params, struct reg_param *reg_params,
+		uint32_t entry_point, uint32_t exit_point,
+		void *arch_info);
+/**
+ * Wait for an algorithm started by target_start_algorithm() to reach
+ * @a exit_point, and collect its results.
+ *
+ * This routine is a wrapper for target->type->wait_algorithm.
+ */
+int target_wait_algorithm(struct target *target,
+		int num_mem_params, struct mem_param *mem_params,
+		int num_reg_params, struct reg_param *reg_params,
+		uint32_t exit_point, int timeout_ms,
+		void *arch_info);
+
+/**
+ * Start a series of target_run_algorithm() calls using the same
+ * @a arch_info, such as one per buffer while writing flash.  The core
+ * state is saved here, once, instead of around every call, and the
+ * registers the algorithm leaves behind are not restored in between;
+ * each call still loads its own parameters.
+ *
+ * Targets without support for this simply save and restore around
+ * every call, so it is always safe to use.
+ *
+ * This routine is a wrapper for target->type->begin_algorithm_session.
+ */
+int target_begin_algorithm_session(struct target *target, void *arch_info);
+/**
+ * Restore the core state saved by target_begin_algorithm_session().
+ * Call it even when an algorithm failed.
+ *
+ * This routine is a wrapper for target->type->end_algorithm_session.
+ */
+int target_end_algorithm_session(struct target *target, void *arch_info);
+
 /**
  * Read @a count items of @a size bytes from the memory of @a target at
  * the @a address given.
@@ -384,6 +440,81 @@ int target_run_algorithm(struct target *target,
  */
 int target_read_memory(struct target *target,
 		uint32_t address, uint32_t size, uint32_t count, uint8_t *buffer);
+/** One item of a target_read_memory_vector(), target_write_memory_vector()
+ * or target_access_memory_vector() request. */
+struct target_memory_item {
+	uint32_t address;
+	/** access size: 1, 2 or 4 bytes; @a address must be aligned to it */
+	uint32_t size;
+	/** the value read or to write, in host byte order */
+	uint32_t value;
+	/** write rather than read; only target_access_memory_vector()
+	 * looks at this, the others set it */
+	bool write;
+};
+
+/**
+ * Read @a count unrelated items from the memory of @a target, e.g. for
+ * register dumps or walking linked structures.  Targets which can queue
+ * the reads do so and flush once, instead of once per item.
+ *
+ * This routine is a wrapper for target->type->read_memory_vector,
+ * falling back to target->type->read_memory.
+ */
+int target_read_memory_vector(struct target *target,
+		struct target_memory_item *items, unsigned count);
+/**
+ * Write @a count unrelated items, in order, to the memory of @a target.
+ * Targets which can queue the writes do so and flush once.
+ *
+ * This routine is a wrapper for target->type->write_memory_vector,
+ * falling back to target->type->write_memory.
+ */
+int target_write_memory_vector(struct target *target,
+		struct target_memory_item *items, unsigned count);
+
+/**
+ * Read and write a vector of items, in order; e.g. command writes and
+ * the status reads which follow them.  Targets which can queue both
+ * do so and flush once.
+ *
+ * This routine is a wrapper for target->type->access_memory_vector,
+ * falling back to the read and write vector methods.
+ */
+int target_access_memory_vector(struct target *target,
+		struct target_memory_item *items, unsigned count);
+
+/**
+ * Start collecting target_write_u32(), target_write_u16() and
+ * target_write_u8() calls instead of issuing each one, e.g. for the
+ * register writes of a flash erase.  They are sent together, with
+ * target_access_memory_vector(), at the next read or other access to
+ * the target (a barrier), or at target_flush().  Errors from collected
+ * writes are reported there.  Calls nest.
+ */
+void target_begin_write_combining(struct target *target);
+/** Leave write combining mode, flushing when the outermost call ends. */
+int target_end_write_combining(struct target *target);
+/** Issue any writes collected in write combining mode, and any
+ * target_read_u32_async() reads. */
+int target_flush(struct target *target);
+
+/** Handle for target_read_u32_async(). */
+struct target_async_read {
+	/** set once the read was sent; @a retval and @a value are valid */
+	bool done;
+	int retval;
+	uint32_t value;
+};
+
+/**
+ * Queue a read of the word at @a address, e.g. a flash status register.
+ * It is sent, in order with writes collected by write combining, at
+ * the next target_flush() or barrier; then @a handle is filled in.
+ * The handle must stay valid until then.
+ */
+int target_read_u32_async(struct target *target, uint32_t address,
+		struct target_async_read *handle);
 /**
  * Write @a count items of @a size bytes to the memory of @a target at
  * the @a address given. @a address must be aligned to @a size
@@ -448,6 +579,17 @@ int target_blank_check_memory(struct target *target,
 		uint32_t address, uint32_t size, uint32_t* blank);
 int target_wait_state(struct target *target, enum target_state state, int ms);
 
+/**
+ * Collect PC samples from a running @a target for @a seconds, or until
+ * @a max_num_samples have been taken.  Uses target->type->profiling
+ * when the core can sample without halting, else
+ * target_profiling_default(), which halts and resumes for every sample.
+ */
+int target_profiling(struct target *target, uint32_t *samples,
+		uint32_t max_num_samples, uint32_t *num_samples, uint32_t seconds);
+int target_profiling_default(struct target *target, uint32_t *samples,
+		uint32_t max_num_samples, uint32_t *num_samples, uint32_t seconds);
+
 /** Return the *name* of this targets current state */
 const char *target_state_name( struct target *target );
 
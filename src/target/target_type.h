@@ -30,6 +30,7 @@
 #include <jim-nvp.h>
 
 struct target;
+struct target_memory_item;
 
 /**
  * This holds methods shared between all instances of a given target
@@ -119,6 +120,26 @@ struct target_type
 	 */
 	int (*write_memory)(struct target *target, uint32_t address, uint32_t size, uint32_t count, uint8_t *buffer);
 
+	/**
+	 * Read a vector of single, unrelated items with as few queue
+	 * flushes as possible.  Optional.  Do @b not call this function
+	 * directly, use target_read_memory_vector() instead.
+	 */
+	int (*read_memory_vector)(struct target *target, struct target_memory_item *items, unsigned count);
+	/**
+	 * Write a vector of single, unrelated items with as few queue
+	 * flushes as possible, in order.  Optional.  Do @b not call this
+	 * function directly, use target_write_memory_vector() instead.
+	 */
+	int (*write_memory_vector)(struct target *target, struct target_memory_item *items, unsigned count);
+	/**
+	 * Read and write a vector of items, as their @a write flags say, in
+	 * order and with as few queue flushes as possible.  Optional.  Do
+	 * @b not call this function directly, use
+	 * target_access_memory_vector() instead.
+	 */
+	int (*access_memory_vector)(struct target *target, struct target_memory_item *items, unsigned count);
+
 	/**
 	 * Write target memory in multiples of 4 bytes, optimized for
 	 * writing large quantities of data.  Do @b not call this
@@ -163,6 +184,23 @@ struct target_type
 	 * use target_run_algorithm() instead.
 	 */
 	int (*run_algorithm)(struct target *target, int num_mem_params, struct mem_param *mem_params, int num_reg_params, struct reg_param *reg_param, uint32_t entry_point, uint32_t exit_point, int timeout_ms, void *arch_info);
+	/**
+	 * Start an algorithm and return while it runs, then wait for it
+	 * to finish.  Optional, and only for cores whose memory can be
+	 * accessed while they run (e.g. through a MEM-AP); leave NULL
+	 * elsewhere.  Do @b not call these methods directly,
+	 * use target_start_algorithm() and target_wait_algorithm() instead.
+	 */
+	int (*start_algorithm)(struct target *target, int num_mem_params, struct mem_param *mem_params, int num_reg_params, struct reg_param *reg_param, uint32_t entry_point, uint32_t exit_point, void *arch_info);
+	int (*wait_algorithm)(struct target *target, int num_mem_params, struct mem_param *mem_params, int num_reg_params, struct reg_param *reg_param, uint32_t exit_point, int timeout_ms, void *arch_info);
+	/**
+	 * Save the core state once for a series of run_algorithm calls,
+	 * and restore it at the end of the session.  Optional.  Do @b not
+	 * call these methods directly, use target_begin_algorithm_session()
+	 * and target_end_algorithm_session() instead.
+	 */
+	int (*begin_algorithm_session)(struct target *target, void *arch_info);
+	int (*end_algorithm_session)(struct target *target, void *arch_info);
 
 	const struct command_registration *commands;
 
@@ -230,6 +268,14 @@ struct target_type
 	 * circumstances.
 	 */
 	int (*check_reset)(struct target *target);
+
+	/**
+	 * Sample the PC of a running target, without halting it.
+	 * Optional.  Do @b not call this function directly, use
+	 * target_profiling() instead.
+	 */
+	int (*profiling)(struct target *target, uint32_t *samples,
+			uint32_t max_num_samples, uint32_t *num_samples, uint32_t seconds);
 };
 
 #endif // TARGET_TYPE_H
@@ -3869,6 +3869,8 @@ struct target_type xscale_target =
 	.blank_check_memory = arm_blank_check_memory,
 
 	.run_algorithm = armv4_5_run_algorithm,
+	.begin_algorithm_session = armv4_5_begin_algorithm_session,
+	.end_algorithm_session = armv4_5_end_algorithm_session,
 
 	.add_breakpoint = xscale_add_breakpoint,
 	.remove_breakpoint = xscale_remove_breakpoint,
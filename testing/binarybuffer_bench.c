@@ -0,0 +1,112 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/*
+ * Host side micro-benchmark for the bit-field helpers which build and
+ * pick apart JTAG scan buffers.  Prints how many bits per second
+ * buf_set_buf() and buf_cmp_mask() manage for field sizes from 1 bit
+ * to 1 MB, aligned and unaligned.
+ *
+ * Build it from a configured tree, e.g.:
+ *
+ *   gcc -O2 -std=gnu99 -DHAVE_CONFIG_H -I. -Isrc -Isrc/helper \
+ *       testing/binarybuffer_bench.c src/helper/binarybuffer.c \
+ *       -o binarybuffer_bench
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <helper/binarybuffer.h>
+#include <helper/log.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#define MAX_BITS	(8u << 20)	/* 1 MB */
+
+/* binarybuffer.c logs through these */
+int debug_level;
+
+void log_printf_lf(enum log_levels level, const char *file, unsigned line,
+		const char *function, const char *format, ...)
+{
+}
+
+static double now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/* keeps the compiler from discarding the compares */
+static volatile unsigned sink;
+
+static void bench(const char *name, unsigned bits,
+		unsigned src_start, unsigned dst_start,
+		const uint8_t *a, uint8_t *b, const uint8_t *mask)
+{
+	/* aim for roughly the same amount of work at every size */
+	unsigned loops = (64u << 20) / (bits + 64) + 1;
+	double start, elapsed;
+
+	start = now();
+	for (unsigned i = 0; i < loops; i++)
+	{
+		if (mask)
+			sink += buf_cmp_mask(a, b, mask, bits);
+		else
+			buf_set_buf(a, src_start, b, dst_start, bits);
+	}
+	elapsed = now() - start;
+
+	printf("%-20s %8u bits  %10.1f Mbit/s\n", name, bits,
+			elapsed > 0 ? (double)bits * loops / elapsed / 1e6 : 0.0);
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned size = DIV_ROUND_UP(MAX_BITS, 8) + 8;
+	uint8_t *a = malloc(size), *b = malloc(size), *mask = malloc(size);
+
+	if (!a || !b || !mask)
+		return 1;
+
+	for (unsigned i = 0; i < size; i++)
+	{
+		a[i] = rand();
+		mask[i] = 0xff;
+	}
+	memcpy(b, a, size);
+
+	for (unsigned bits = 1; bits <= MAX_BITS; bits *= 2)
+	{
+		bench("set_buf aligned", bits, 0, 0, a, b, NULL);
+		bench("set_buf dst +3", bits, 0, 3, a, b, NULL);
+		bench("set_buf src +5", bits, 5, 0, a, b, NULL);
+		memcpy(b, a, size);
+		bench("cmp_mask", bits, 0, 0, a, b, mask);
+	}
+
+	free(mask);
+	free(b);
+	free(a);
+
+	return 0;
+}
@@ -0,0 +1,132 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/*
+ * Host side benchmark for image_calculate_checksum(), the gdb style
+ * CRC32 used by verify_image, qCRC and target_checksum_memory().  CRCs
+ * a 64 MB buffer, and checks it and some short unaligned runs against
+ * a plain byte at a time CRC.
+ *
+ * Build it from a configured tree, e.g.:
+ *
+ *   gcc -O2 -std=gnu99 -DHAVE_CONFIG_H -I. -Isrc -Isrc/helper -Ijimtcl \
+ *       testing/crc_bench.c src/target/image.c src/helper/fileio.c \
+ *       -o crc_bench
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <target/image.h>
+#include <helper/log.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#define BUFFER_SIZE	(64u << 20)
+
+/* image.c and fileio.c call out to these */
+int debug_level;
+
+void log_printf_lf(enum log_levels level, const char *file, unsigned line,
+		const char *function, const char *format, ...)
+{
+}
+
+void keep_alive(void)
+{
+}
+
+FILE *open_file_from_path(char *file, char *mode)
+{
+	return fopen(file, mode);
+}
+
+struct target *get_target(const char *id)
+{
+	return NULL;
+}
+
+int target_read_buffer(struct target *target,
+		uint32_t address, uint32_t size, uint8_t *buffer)
+{
+	return ERROR_FAIL;
+}
+
+static double now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/* the original, one bit at a time rather than through a table */
+static uint32_t reference_crc(const uint8_t *buffer, uint32_t nbytes)
+{
+	uint32_t crc = 0xffffffff;
+	int j;
+
+	while (nbytes--)
+	{
+		crc ^= (uint32_t)*buffer++ << 24;
+		for (j = 0; j < 8; j++)
+			crc = crc & 0x80000000 ? (crc << 1) ^ 0x04c11db7 : (crc << 1);
+	}
+
+	return crc;
+}
+
+int main(int argc, char *argv[])
+{
+	uint8_t *buffer = malloc(BUFFER_SIZE);
+	uint32_t crc, expected;
+	double start, elapsed;
+	unsigned i;
+
+	if (!buffer)
+		return 1;
+
+	for (i = 0; i < BUFFER_SIZE; i++)
+		buffer[i] = rand();
+
+	/* every alignment and tail length the unrolled loop can see */
+	for (i = 0; i < 64; i++)
+	{
+		image_calculate_checksum(buffer + (i & 7), i, &crc);
+		expected = reference_crc(buffer + (i & 7), i);
+		if (crc != expected)
+		{
+			printf("mismatch at %u bytes: 0x%08" PRIx32 " != 0x%08" PRIx32 "\n",
+					i, crc, expected);
+			return 1;
+		}
+	}
+
+	start = now();
+	image_calculate_checksum(buffer, BUFFER_SIZE, &crc);
+	elapsed = now() - start;
+
+	expected = reference_crc(buffer, BUFFER_SIZE);
+	printf("%u MB crc 0x%08" PRIx32 " (%s) in %.3fs, %.1f MB/s\n",
+			BUFFER_SIZE >> 20, crc, crc == expected ? "ok" : "MISMATCH",
+			elapsed, elapsed > 0 ? BUFFER_SIZE / elapsed / 1e6 : 0.0);
+
+	free(buffer);
+
+	return crc != expected;
+}
@@ -0,0 +1,222 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/*
+ * Loopback benchmark for the GDB server's packet handling.  Connects to
+ * a running OpenOCD, switches to no-ack mode, then times round trips of
+ * the packets GDB sends most: small and large 'm' and 'x' reads, 'M'
+ * and 'X' writes, 'g', and 'vFlashWrite' (which is only buffered until
+ * a vFlashDone, so no flash is needed).
+ *
+ * Point it at RAM on a halted target, or at the dummy driver's
+ * simulated Cortex-M to measure OpenOCD itself rather than an adapter:
+ *
+ *   openocd -f interface/dummy.cfg -c "dummy tap dap 0x4ba00477" \
+ *       -c "jtag newtap sim cpu -irlen 4 -expected-id 0x4ba00477" \
+ *       -c "target create sim.cpu cortex_m3 -chain-position sim.cpu"
+ *   gcc -O2 -std=gnu99 testing/gdb_bench.c -o gdb_bench
+ *   ./gdb_bench localhost 3333 0x20000000
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+static int sock;
+static char in_buf[256 * 1024];
+static int in_pos, in_cnt;
+static char reply[256 * 1024];
+static char packet[256 * 1024];
+
+static double now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static int get_char(void)
+{
+	if (in_pos == in_cnt)
+	{
+		in_cnt = read(sock, in_buf, sizeof(in_buf));
+		if (in_cnt <= 0)
+		{
+			fprintf(stderr, "connection closed\n");
+			exit(1);
+		}
+		in_pos = 0;
+	}
+	return (unsigned char)in_buf[in_pos++];
+}
+
+static void put_packet(const char *data, int len)
+{
+	unsigned char sum = 0;
+	int i;
+
+	packet[0] = '$';
+	memcpy(packet + 1, data, len);
+	for (i = 0; i < len; i++)
+		sum += (unsigned char)data[i];
+	sprintf(packet + 1 + len, "#%02x", sum);
+
+	if (write(sock, packet, len + 4) != len + 4)
+	{
+		fprintf(stderr, "write failed\n");
+		exit(1);
+	}
+}
+
+/* the next reply's payload, skipping console output */
+static int get_reply(void)
+{
+	int c, len;
+
+	for (;;)
+	{
+		while ((c = get_char()) != '$')
+			;
+		len = 0;
+		while ((c = get_char()) != '#')
+			reply[len++] = c;
+		get_char();
+		get_char();
+
+		if ((reply[0] != 'O') || (len == 2 && reply[1] == 'K'))
+			return len;
+	}
+}
+
+static void bench(const char *name, const char *data, int len,
+		int payload, int count)
+{
+	double start, elapsed;
+	int i, n = 0;
+
+	/* once to show what we get back */
+	put_packet(data, len);
+	n = get_reply();
+	if ((n > 0) && (reply[0] == 'E'))
+		printf("%-24s replied %.*s\n", name, n, reply);
+
+	start = now();
+	for (i = 0; i < count; i++)
+	{
+		put_packet(data, len);
+		get_reply();
+	}
+	elapsed = now() - start;
+
+	printf("%-24s %8.0f packets/s  %8.2f MB/s\n", name,
+			count / elapsed, (double)payload * count / elapsed / 1e6);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *host = (argc > 1) ? argv[1] : "localhost";
+	const char *port = (argc > 2) ? argv[2] : "3333";
+	unsigned long address = (argc > 3) ? strtoul(argv[3], NULL, 0) : 0x20000000;
+	struct addrinfo hints, *ai;
+	static const int sizes[] = { 4, 1024, 8192 };
+	char data[64 * 1024];
+	int one = 1;
+	unsigned i;
+	int len;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_socktype = SOCK_STREAM;
+	if (getaddrinfo(host, port, &hints, &ai) != 0)
+	{
+		fprintf(stderr, "can't resolve %s:%s\n", host, port);
+		return 1;
+	}
+	sock = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+	if ((sock < 0) || (connect(sock, ai->ai_addr, ai->ai_addrlen) != 0))
+	{
+		fprintf(stderr, "can't connect to %s:%s\n", host, port);
+		return 1;
+	}
+	freeaddrinfo(ai);
+	setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+	/* initial ack, then no more of them */
+	if (write(sock, "+", 1) != 1)
+		return 1;
+	put_packet("QStartNoAckMode", 15);
+	while (get_char() != '+')
+		;
+	get_reply();
+	if (write(sock, "+", 1) != 1)
+		return 1;
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+	{
+		char name[32];
+		int size = sizes[i];
+
+		len = sprintf(data, "m%lx,%x", address, size);
+		sprintf(name, "m %d", size);
+		bench(name, data, len, size, 20000 / (1 + size / 256));
+
+		len = sprintf(data, "x%lx,%x", address, size);
+		sprintf(name, "x %d", size);
+		bench(name, data, len, size, 20000 / (1 + size / 256));
+
+		len = sprintf(data, "M%lx,%x:", address, size);
+		memset(data + len, 'a', size * 2);
+		sprintf(name, "M %d", size);
+		bench(name, data, len + size * 2, size, 20000 / (1 + size / 256));
+
+		/* payload bytes which don't need escaping */
+		len = sprintf(data, "X%lx,%x:", address, size);
+		memset(data + len, 0x55, size);
+		sprintf(name, "X %d", size);
+		bench(name, data, len + size, size, 20000 / (1 + size / 256));
+	}
+
+	bench("g", "g", 1, 0, 20000);
+
+	/* buffered by the server, so use a fresh address each time */
+	{
+		double start, elapsed;
+		int count = 1000, size = 16 * 1024;
+
+		start = now();
+		for (i = 0; i < (unsigned)count; i++)
+		{
+			len = sprintf(data, "vFlashWrite:%lx:", address + i * size);
+			memset(data + len, 0x55, size);
+			put_packet(data, len + size);
+			get_reply();
+		}
+		elapsed = now() - start;
+
+		printf("%-24s %8.0f packets/s  %8.2f MB/s\n", "vFlashWrite 16384",
+				count / elapsed, (double)size * count / elapsed / 1e6);
+	}
+
+	close(sock);
+
+	return 0;
+}
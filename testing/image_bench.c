@@ -0,0 +1,174 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/*
+ * Host side benchmark for the IHEX and S-record parsers.  Writes a
+ * 16 MB .hex file and the same data as a .s19 file (or uses the files
+ * named on the command line), then times image_open() on them.
+ *
+ * Build it from a configured tree, e.g.:
+ *
+ *   gcc -O2 -std=gnu99 -DHAVE_CONFIG_H -I. -Isrc -Isrc/helper -Ijimtcl \
+ *       testing/image_bench.c src/target/image.c src/helper/fileio.c \
+ *       -o image_bench
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <target/image.h>
+#include <helper/log.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#define HEX_FILE_SIZE	(16u << 20)
+
+/* image.c and fileio.c call out to these */
+int debug_level;
+
+void log_printf_lf(enum log_levels level, const char *file, unsigned line,
+		const char *function, const char *format, ...)
+{
+}
+
+void keep_alive(void)
+{
+}
+
+FILE *open_file_from_path(char *file, char *mode)
+{
+	return fopen(file, mode);
+}
+
+struct target *get_target(const char *id)
+{
+	return NULL;
+}
+
+int target_read_buffer(struct target *target,
+		uint32_t address, uint32_t size, uint8_t *buffer)
+{
+	return ERROR_FAIL;
+}
+
+static double now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/* 16 data bytes per record, as most tools emit them */
+static void write_hex(const char *name, int srec)
+{
+	FILE *f = fopen(name, "w");
+	uint32_t address = 0x08000000;
+	unsigned i;
+
+	while (ftell(f) < HEX_FILE_SIZE)
+	{
+		uint8_t sum;
+
+		if (srec)
+		{
+			sum = 21 + (address >> 24) + (address >> 16) + (address >> 8) + address;
+			fprintf(f, "S315%08X", (unsigned)address);
+		}
+		else
+		{
+			if ((address & 0xffff) == 0)
+			{
+				sum = 6 + (address >> 24) + (address >> 16);
+				fprintf(f, ":02000004%04X%02X\n", (unsigned)(address >> 16),
+						(uint8_t)-sum);
+			}
+			sum = 16 + (address >> 8) + address;
+			fprintf(f, ":10%04X00", (unsigned)(address & 0xffff));
+		}
+
+		for (i = 0; i < 16; i++)
+		{
+			uint8_t value = rand();
+			fprintf(f, "%02X", value);
+			sum += value;
+		}
+		fprintf(f, "%02X\n", srec ? (uint8_t)~sum : (uint8_t)-sum);
+		address += 16;
+	}
+
+	fprintf(f, srec ? "S70500000000FA\n" : ":00000001FF\n");
+	fclose(f);
+}
+
+static void bench(const char *name, const char *type)
+{
+	struct image image;
+	double start, elapsed;
+	uint32_t bytes = 0;
+	FILE *f;
+	long size;
+	int i;
+
+	f = fopen(name, "r");
+	if (!f)
+		return;
+	fseek(f, 0, SEEK_END);
+	size = ftell(f);
+	fclose(f);
+
+	image.base_address_set = 0;
+	image.start_address_set = 0;
+
+	start = now();
+	if (image_open(&image, name, type) != ERROR_OK)
+	{
+		printf("%s: parse failed\n", name);
+		return;
+	}
+	elapsed = now() - start;
+
+	for (i = 0; i < image.num_sections; i++)
+		bytes += image.sections[i].size;
+	image_close(&image);
+
+	printf("%-20s %10ld bytes -> %9" PRIu32 " bytes in %d sections, "
+			"%.3fs (%.1f MB/s)\n", name, size, bytes, image.num_sections,
+			elapsed, elapsed > 0 ? size / elapsed / 1e6 : 0.0);
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc > 1)
+	{
+		for (int i = 1; i < argc; i++)
+			bench(argv[i], NULL);
+		return 0;
+	}
+
+	write_hex("image_bench.hex", 0);
+	write_hex("image_bench.s19", 1);
+
+	bench("image_bench.hex", "ihex");
+	bench("image_bench.s19", "s19");
+
+	remove("image_bench.hex");
+	remove("image_bench.s19");
+
+	return 0;
+}